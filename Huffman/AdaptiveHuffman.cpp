@@ -0,0 +1,266 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the FGK adaptive Huffman model. Nodes are numbered so that
+ * weights never decrease as the numbers go up and siblings have adjacent numbers (the sibling
+ * property); the root has the highest number and NYT the lowest. To count a character, we walk
+ * from its leaf to the root, and before incrementing each node we swap it with the highest
+ * numbered node of the same weight (unless that's its parent), which keeps the property true
+ * after the increment. Node numbers are simply array indexes, so a swap exchanges the contents
+ * of two slots and re-points their children.
+ */
+
+#include "AdaptiveHuffman.h"
+#include <algorithm>
+
+static const int INTERNAL = -1; //mySymbol value for internal nodes
+static const int NYT = -2; //mySymbol value for the NYT leaf
+static const int RAW_SYMBOL_BITS = 9; //enough for 0-255 plus PSEUDO_EOF
+static const int ROOT = ADAPTIVE_MAX_NODES - 1;
+
+AdaptiveHuffmanModel::AdaptiveHuffmanModel() {
+    reset();
+}
+
+void AdaptiveHuffmanModel::reset() {
+    for (int ch = 0; ch < ADAPTIVE_SYMBOLS; ch++) {
+        myLeaf[ch] = -1;
+    }
+    myNYT = ROOT;
+    myWeight[ROOT] = 0;
+    myParent[ROOT] = -1;
+    myZero[ROOT] = -1;
+    myOne[ROOT] = -1;
+    mySymbol[ROOT] = NYT;
+}
+
+/*
+ * Collects the path from the root to ch's leaf, or to NYT if ch hasn't been seen, by walking up
+ * from the leaf.
+ * @ch: the character to encode
+ */
+int AdaptiveHuffmanModel::pathTo(int ch) {
+    int node = myLeaf[ch] >= 0 ? myLeaf[ch] : myNYT;
+    int depth = 0;
+    while (node != ROOT) {
+        int parent = myParent[node];
+        myPath[depth++] = (myOne[parent] == node) ? 1 : 0;
+        node = parent;
+    }
+    return depth;
+}
+
+/*
+ * Writes the path from the root to ch's leaf (or to NYT followed by the raw character).
+ * @ch: the character to encode
+ * @output: where the bits are written
+ */
+void AdaptiveHuffmanModel::writeSymbol(int ch, obitstream& output) {
+    for (int depth = pathTo(ch); depth > 0; depth--) { //root-first
+        output.writeBit(myPath[depth - 1]);
+    }
+    if (myLeaf[ch] < 0) {
+        for (int i = 0; i < RAW_SYMBOL_BITS; i++) {
+            output.writeBit((ch >> i) & 1);
+        }
+    }
+    update(ch);
+}
+
+void AdaptiveHuffmanModel::writeSymbol(int ch, BitWriter& output) {
+    for (int depth = pathTo(ch); depth > 0; depth--) {
+        output.writeBit(myPath[depth - 1]);
+    }
+    if (myLeaf[ch] < 0) {
+        output.writeBits((uint64_t) ch, RAW_SYMBOL_BITS);
+    }
+    update(ch);
+}
+
+/*
+ * Follows bits from the root down to a leaf, mirroring writeSymbol.
+ * @input: where the bits are read from
+ */
+int AdaptiveHuffmanModel::readSymbol(ibitstream& input) {
+    int node = ROOT;
+    while (mySymbol[node] == INTERNAL) {
+        int bit = input.readBit();
+        if (bit != 0 && bit != 1) return -1;
+        node = bit == 1 ? myOne[node] : myZero[node];
+    }
+    int ch = mySymbol[node];
+    if (ch == NYT) {
+        ch = 0;
+        for (int i = 0; i < RAW_SYMBOL_BITS; i++) {
+            int bit = input.readBit();
+            if (bit != 0 && bit != 1) return -1;
+            ch |= bit << i;
+        }
+        if (ch >= ADAPTIVE_SYMBOLS || myLeaf[ch] >= 0) return -1; //not something an encoder could send
+    }
+    update(ch);
+    return ch;
+}
+
+int AdaptiveHuffmanModel::readSymbol(BitReader& input) {
+    int node = ROOT;
+    while (mySymbol[node] == INTERNAL) {
+        int bit = input.readBit();
+        if (bit < 0) return -1;
+        node = bit == 1 ? myOne[node] : myZero[node];
+    }
+    int ch = mySymbol[node];
+    if (ch == NYT) {
+        int64_t raw = input.readBits(RAW_SYMBOL_BITS);
+        if (raw < 0 || raw >= ADAPTIVE_SYMBOLS || myLeaf[raw] >= 0) return -1;
+        ch = (int) raw;
+    }
+    update(ch);
+    return ch;
+}
+
+/*
+ * The FGK update. New characters first split NYT; then each node on the way up is moved to the
+ * top of its block of equal weights and incremented.
+ * Big-Oh: O(depth * block size), effectively constant for a 257-character alphabet
+ * @ch: the character that was just coded
+ */
+void AdaptiveHuffmanModel::update(int ch) {
+    if (myLeaf[ch] < 0) spawn(ch);
+    int node = myLeaf[ch];
+    while (node >= 0) {
+        int leader = node;
+        while (leader < ROOT && myWeight[leader + 1] == myWeight[node]) { //equal weights are contiguous
+            leader++;
+        }
+        if (leader != node && leader != myParent[node]) {
+            swapNodes(node, leader);
+            node = leader;
+        }
+        myWeight[node]++;
+        node = myParent[node];
+    }
+    if (myWeight[ROOT] >= ADAPTIVE_MAX_WEIGHT) rescale();
+}
+
+/*
+ * NYT becomes an internal node whose children are a new NYT (numbered lowest) and a leaf for ch.
+ * @ch: the character being added to the tree
+ */
+void AdaptiveHuffmanModel::spawn(int ch) {
+    int parent = myNYT;
+    int leaf = parent - 1;
+    int newNYT = parent - 2;
+    mySymbol[parent] = INTERNAL;
+    myOne[parent] = leaf;
+    myZero[parent] = newNYT;
+
+    myWeight[leaf] = 0;
+    myParent[leaf] = parent;
+    myZero[leaf] = myOne[leaf] = -1;
+    mySymbol[leaf] = ch;
+    myLeaf[ch] = leaf;
+
+    myWeight[newNYT] = 0;
+    myParent[newNYT] = parent;
+    myZero[newNYT] = myOne[newNYT] = -1;
+    mySymbol[newNYT] = NYT;
+    myNYT = newNYT;
+}
+
+/*
+ * Swaps what hangs off two node numbers. The numbers keep their parents (that's the point of the
+ * swap); only the contents and the back-pointers to them move. Both have the same weight.
+ */
+void AdaptiveHuffmanModel::swapNodes(int a, int b) {
+    swap(mySymbol[a], mySymbol[b]);
+    swap(myZero[a], myZero[b]);
+    swap(myOne[a], myOne[b]);
+    swap(myWeight[a], myWeight[b]);
+    fixLinks(a);
+    fixLinks(b);
+}
+
+void AdaptiveHuffmanModel::fixLinks(int index) {
+    if (mySymbol[index] == INTERNAL) {
+        myParent[myZero[index]] = index;
+        myParent[myOne[index]] = index;
+    } else if (mySymbol[index] == NYT) {
+        myNYT = index;
+    } else {
+        myLeaf[mySymbol[index]] = index;
+    }
+}
+
+/*
+ * Halves every character's count (keeping seen characters at 1 or more) and rebuilds the tree
+ * with the two-queue Huffman merge. Numbering the nodes in the order the merge removes them from
+ * the queues gives nondecreasing weights with siblings side by side, so the rebuilt tree has the
+ * sibling property. Both sides rescale at the same moment, so they stay in step.
+ * Big-Oh: O(NlogN) for N characters seen, once every ADAPTIVE_MAX_WEIGHT / 2 or so characters
+ */
+void AdaptiveHuffmanModel::rescale() {
+    // temporary nodes: leaves (NYT first, then characters by weight), then internal nodes
+    int weight[ADAPTIVE_MAX_NODES];
+    int symbol[ADAPTIVE_MAX_NODES];
+    int zero[ADAPTIVE_MAX_NODES];
+    int one[ADAPTIVE_MAX_NODES];
+    int number[ADAPTIVE_MAX_NODES];
+    pair<int, int> leaves[ADAPTIVE_SYMBOLS];
+
+    int numSeen = 0;
+    for (int ch = 0; ch < ADAPTIVE_SYMBOLS; ch++) {
+        if (myLeaf[ch] >= 0) {
+            leaves[numSeen++] = make_pair((myWeight[myLeaf[ch]] + 1) / 2, ch);
+        }
+    }
+    sort(leaves, leaves + numSeen);
+    int numLeaves = numSeen + 1;
+    weight[0] = 0;
+    symbol[0] = NYT;
+    for (int i = 0; i < numSeen; i++) {
+        weight[i + 1] = leaves[i].first;
+        symbol[i + 1] = leaves[i].second;
+    }
+
+    int size = numLeaves;
+    int nextLeaf = 0;
+    int nextInternal = numLeaves;
+    int nextNumber = ROOT - (2 * numLeaves - 2); //the lowest number in use
+    while (size < 2 * numLeaves - 1) {
+        int children[2];
+        for (int k = 0; k < 2; k++) {
+            if (nextLeaf < numLeaves && (nextInternal == size || weight[nextLeaf] <= weight[nextInternal])) {
+                children[k] = nextLeaf++;
+            } else {
+                children[k] = nextInternal++;
+            }
+            number[children[k]] = nextNumber++;
+        }
+        weight[size] = weight[children[0]] + weight[children[1]];
+        symbol[size] = INTERNAL;
+        zero[size] = children[0];
+        one[size] = children[1];
+        size++;
+    }
+    number[size - 1] = ROOT;
+
+    myParent[ROOT] = -1;
+    for (int i = 0; i < size; i++) {
+        int n = number[i];
+        myWeight[n] = weight[i];
+        mySymbol[n] = symbol[i];
+        if (symbol[i] == INTERNAL) {
+            myZero[n] = number[zero[i]];
+            myOne[n] = number[one[i]];
+        } else {
+            myZero[n] = myOne[n] = -1;
+        }
+        fixLinks(n);
+    }
+    for (int i = 0; i < size; i++) { //parents are only known once every node has its number
+        if (symbol[i] == INTERNAL) {
+            myParent[number[zero[i]]] = number[i];
+            myParent[number[one[i]]] = number[i];
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the AdaptiveHuffman.h file which declares the model behind adaptive (one-pass) Huffman
+ * coding. The encoder and decoder each keep one of these models and update it identically after
+ * every character, so no frequency table is ever sent and the input never has to be rewound.
+ * See compressAdaptive/decompressAdaptive in encoding.h for whole-stream use.
+ */
+
+#ifndef _adaptivehuffman_h
+#define _adaptivehuffman_h
+
+#include "bitstream.h"
+#include "BitIO.h"
+using namespace std;
+
+const int ADAPTIVE_SYMBOLS = PSEUDO_EOF + 1;                // every byte plus EOF
+const int ADAPTIVE_MAX_NODES = 2 * ADAPTIVE_SYMBOLS + 1;    // a leaf and a parent per symbol, plus NYT
+const int ADAPTIVE_MAX_WEIGHT = 1 << 16;                    // counts are halved when the root reaches this
+
+/*
+ * An FGK adaptive Huffman tree. Characters that haven't been seen yet share one zero-weight
+ * "not yet transmitted" (NYT) leaf; the first time a character appears, the NYT code is sent
+ * followed by the character's raw 9-bit value. The tree uses a fixed node array and the
+ * counts are periodically halved, so memory use is constant however long the stream runs.
+ */
+class AdaptiveHuffmanModel {
+public:
+    AdaptiveHuffmanModel();
+
+    /*
+     * Forgets everything seen so far (back to a tree holding only NYT).
+     */
+    void reset();
+
+    /*
+     * Writes the code for the given character (0-255 or PSEUDO_EOF), then updates the model.
+     */
+    void writeSymbol(int ch, obitstream& output);
+    void writeSymbol(int ch, BitWriter& output);
+
+    /*
+     * Reads one character's code, updates the model, and returns the character
+     * (PSEUDO_EOF included), or -1 if the input ran out in the middle of a code.
+     */
+    int readSymbol(ibitstream& input);
+    int readSymbol(BitReader& input);
+
+private:
+    int pathTo(int ch); //stores the code for ch (NYT's, if ch is new) in myPath leaf-first, returns its length
+    void update(int ch); //counts one more occurrence of ch, keeping the sibling property
+    void spawn(int ch); //splits NYT into a new NYT and a leaf for ch
+    void swapNodes(int a, int b); //exchanges the subtrees at two node numbers
+    void fixLinks(int index); //points the children / leaf table at the node now at index
+    void rescale(); //halves every count and rebuilds the tree
+
+    // node arrays, indexed by node number; higher numbers never have smaller weights
+    int myWeight[ADAPTIVE_MAX_NODES];
+    int myParent[ADAPTIVE_MAX_NODES];
+    int myZero[ADAPTIVE_MAX_NODES];
+    int myOne[ADAPTIVE_MAX_NODES];
+    int mySymbol[ADAPTIVE_MAX_NODES]; //character at a leaf, INTERNAL or NYT otherwise
+    int myLeaf[ADAPTIVE_SYMBOLS]; //node number of each character's leaf, -1 if not seen yet
+    int myNYT; //node number of the NYT leaf
+    int myPath[ADAPTIVE_MAX_NODES]; //scratch space for writing a code root-first
+};
+
+#endif
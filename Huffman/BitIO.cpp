@@ -0,0 +1,132 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the out-of-line parts of BitWriter and BitReader: setting up
+ * and draining the byte buffers, and the slow paths used near the end of the data. The per-bit
+ * work lives inline in BitIO.h.
+ */
+
+#include "BitIO.h"
+
+BitWriter::BitWriter(ostream& output) {
+    init();
+    myStream = &output;
+}
+
+BitWriter::BitWriter(string& output) {
+    init();
+    myString = &output;
+}
+
+void BitWriter::init() {
+    myStream = NULL;
+    myString = NULL;
+    myBuffer = new unsigned char[BUFFER_BYTES + 4]; //room for the word that crosses the limit
+    myBufferSize = 0;
+    myAccumulator = 0;
+    myAccumulatorBits = 0;
+    myBytesDrained = 0;
+}
+
+BitWriter::~BitWriter() {
+    flush();
+    delete[] myBuffer;
+}
+
+void BitWriter::alignToByte() {
+    int partial = myAccumulatorBits & 7;
+    if (partial != 0) writeBits(0, 8 - partial);
+}
+
+/*
+ * Moves the whole bytes left in the accumulator into the buffer, then drains the buffer.
+ */
+void BitWriter::flush() {
+    alignToByte();
+    while (myAccumulatorBits > 0) {
+        myBuffer[myBufferSize++] = (unsigned char) myAccumulator;
+        myAccumulator >>= 8;
+        myAccumulatorBits -= 8;
+    }
+    drainBuffer();
+    if (myStream != NULL) myStream->flush();
+}
+
+uint64_t BitWriter::bitsWritten() const {
+    return (myBytesDrained + myBufferSize) * 8 + myAccumulatorBits;
+}
+
+void BitWriter::drainBuffer() {
+    if (myBufferSize == 0) return;
+    if (myStream != NULL) {
+        myStream->write((const char*) myBuffer, myBufferSize);
+    } else {
+        myString->append((const char*) myBuffer, myBufferSize);
+    }
+    myBytesDrained += myBufferSize;
+    myBufferSize = 0;
+}
+
+BitReader::BitReader(istream& input) {
+    myStream = &input;
+    myBuffer = new unsigned char[BUFFER_BYTES];
+    myNext = myBuffer;
+    myEnd = myBuffer;
+    myWindow = 0;
+    myWindowBits = 0;
+}
+
+BitReader::BitReader(const unsigned char* data, size_t length) {
+    myStream = NULL;
+    myBuffer = NULL;
+    myNext = data;
+    myEnd = data + length;
+    myWindow = 0;
+    myWindowBits = 0;
+}
+
+BitReader::~BitReader() {
+    delete[] myBuffer;
+}
+
+/*
+ * Adds bytes one at a time, reading the next chunk of the stream when the buffer runs out.
+ */
+void BitReader::refillSlow() {
+    while (myWindowBits <= 56) {
+        if (myNext == myEnd) {
+            if (myStream == NULL) return;
+            myStream->read((char*) myBuffer, BUFFER_BYTES);
+            size_t count = (size_t) myStream->gcount();
+            if (count == 0) return;
+            myNext = myBuffer;
+            myEnd = myBuffer + count;
+        }
+        myWindow |= (uint64_t) *myNext++ << myWindowBits;
+        myWindowBits += 8;
+    }
+}
+
+int64_t BitReader::readBits(int count) {
+    if (myWindowBits < count) refill();
+    if (myWindowBits < count) return -1;
+    uint64_t value = myWindow & (((uint64_t) 1 << count) - 1);
+    consume(count);
+    return (int64_t) value;
+}
+
+int BitReader::readBit() {
+    return (int) readBits(1);
+}
+
+/*
+ * The window only ever gains whole bytes, so the bits left over from the current byte are the
+ * window's size mod 8.
+ */
+void BitReader::alignToByte() {
+    consume(myWindowBits & 7);
+}
+
+bool BitReader::atEnd() {
+    refill();
+    return myWindowBits == 0;
+}
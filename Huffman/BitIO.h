@@ -0,0 +1,188 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the BitIO.h file which declares BitWriter and BitReader, a buffered replacement for
+ * obitstream::writeBit and ibitstream::readBit. Bits are collected in a 64-bit accumulator and
+ * moved to and from a large byte buffer a word at a time, so coding a character costs a few
+ * shifts instead of a virtual stream call per bit. The bit order is the same as the Stanford
+ * bitstreams (first bit in the lowest position of each byte), so data written by one can be read
+ * by the other, and an obitstream/ibitstream can be the underlying stream of a writer/reader.
+ */
+
+#ifndef _bitio_h
+#define _bitio_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+using namespace std;
+
+class BitWriter {
+public:
+    /*
+     * Constructs a writer whose bytes are written to the given stream (e.g. an obitstream)
+     * whenever the buffer fills up, and on flush.
+     */
+    BitWriter(ostream& output);
+
+    /*
+     * Constructs a writer whose bytes are appended to the given string.
+     */
+    BitWriter(string& output);
+
+    /*
+     * Flushes any bits that have not been flushed yet.
+     */
+    ~BitWriter();
+
+    /*
+     * Writes the low count bits of bits (at most 32), lowest bit first.
+     * The bits above count must be zero.
+     */
+    void writeBits(uint64_t bits, int count) {
+        myAccumulator |= bits << myAccumulatorBits;
+        myAccumulatorBits += count;
+        if (myAccumulatorBits >= 32) { //move a whole 32-bit word into the buffer
+            unsigned char* p = myBuffer + myBufferSize;
+            p[0] = (unsigned char) myAccumulator;
+            p[1] = (unsigned char) (myAccumulator >> 8);
+            p[2] = (unsigned char) (myAccumulator >> 16);
+            p[3] = (unsigned char) (myAccumulator >> 24);
+            myBufferSize += 4;
+            myAccumulator >>= 32;
+            myAccumulatorBits -= 32;
+            if (myBufferSize >= BUFFER_BYTES) drainBuffer();
+        }
+    }
+
+    void writeBit(int bit) {
+        writeBits((uint64_t) bit, 1);
+    }
+
+    /*
+     * Pads the current byte with zero bits.
+     */
+    void alignToByte();
+
+    /*
+     * Pads the current byte and hands every buffered byte to the output.
+     */
+    void flush();
+
+    /*
+     * Returns the number of bits written so far, including padding.
+     */
+    uint64_t bitsWritten() const;
+
+private:
+    BitWriter(const BitWriter& other);            // not copyable (owns its buffer)
+    BitWriter& operator =(const BitWriter& other);
+
+    static const size_t BUFFER_BYTES = 1 << 16;
+
+    void init();
+    void drainBuffer(); //writes the buffer's bytes to the output and empties it
+
+    ostream* myStream; //output stream, or NULL when writing to a string
+    string* myString; //output string, or NULL when writing to a stream
+    unsigned char* myBuffer;
+    size_t myBufferSize; //number of bytes in myBuffer
+    uint64_t myAccumulator; //bits not yet in the buffer, first bit lowest
+    int myAccumulatorBits; //number of bits in myAccumulator (always less than 32 between calls)
+    uint64_t myBytesDrained; //bytes already handed to the output
+};
+
+class BitReader {
+public:
+    /*
+     * Constructs a reader that pulls bytes from the given stream (e.g. an ibitstream) in large
+     * chunks. It reads ahead, so it should only be used for data that runs to the end of the stream.
+     */
+    BitReader(istream& input);
+
+    /*
+     * Constructs a reader over a range of bytes in memory.
+     */
+    BitReader(const unsigned char* data, size_t length);
+
+    ~BitReader();
+
+    /*
+     * Tops the window up to at least 56 bits, or with whatever input is left.
+     */
+    void refill() {
+        if (myWindowBits <= 56) {
+            if (myEnd - myNext >= 8) { //fast path: one 8-byte load
+                uint64_t word = (uint64_t) myNext[0] | (uint64_t) myNext[1] << 8
+                        | (uint64_t) myNext[2] << 16 | (uint64_t) myNext[3] << 24
+                        | (uint64_t) myNext[4] << 32 | (uint64_t) myNext[5] << 40
+                        | (uint64_t) myNext[6] << 48 | (uint64_t) myNext[7] << 56;
+                myWindow |= word << myWindowBits;
+                int bytes = (63 - myWindowBits) >> 3;
+                myNext += bytes;
+                myWindowBits += bytes * 8;
+            } else {
+                refillSlow();
+            }
+        }
+    }
+
+    /*
+     * Returns the upcoming bits, first bit lowest (bits past the end of the input are zero).
+     */
+    uint64_t window() const {
+        return myWindow;
+    }
+
+    /*
+     * Returns the number of real input bits in the window.
+     */
+    int bitsAvailable() const {
+        return myWindowBits;
+    }
+
+    /*
+     * Drops count bits (no more than bitsAvailable()) from the front of the window.
+     */
+    void consume(int count) {
+        myWindow >>= count;
+        myWindowBits -= count;
+    }
+
+    /*
+     * Reads count bits (at most 32), first bit lowest. Returns -1 if the input ran out first.
+     */
+    int64_t readBits(int count);
+
+    /*
+     * Reads one bit, or returns -1 at the end of the input (like ibitstream::readBit).
+     */
+    int readBit();
+
+    /*
+     * Drops the rest of the current byte.
+     */
+    void alignToByte();
+
+    /*
+     * Returns true if there are no bits left to read.
+     */
+    bool atEnd();
+
+private:
+    BitReader(const BitReader& other);            // not copyable (owns its buffer)
+    BitReader& operator =(const BitReader& other);
+
+    static const size_t BUFFER_BYTES = 1 << 16;
+
+    void refillSlow(); //byte-at-a-time refill near the end of the buffer, reading more of the stream if needed
+
+    istream* myStream; //input stream, or NULL when reading from memory
+    unsigned char* myBuffer; //chunk of the stream being read
+    const unsigned char* myNext; //next byte not yet in the window
+    const unsigned char* myEnd; //end of the bytes available in memory
+    uint64_t myWindow; //upcoming bits, first bit lowest
+    int myWindowBits; //number of real bits in myWindow
+};
+
+#endif
@@ -0,0 +1,286 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the HuffmanPool class. Instead of pushing every node through a
+ * PriorityQueue, the leaves are sorted by count once and then merged with the two-queue method:
+ * the sorted leaves form one queue, and the internal nodes form the other (they are created in
+ * nondecreasing order of count, so appending them to the node array keeps that queue sorted for
+ * free). Each merge just compares the fronts of the two queues, making the build O(N log N) for
+ * the sort and O(N) for the merging.
+ */
+
+#include "HuffmanPool.h"
+#include <algorithm>
+#include "error.h"
+
+static const int INITIAL_LEAF_CAPACITY = PSEUDO_EOF + 1; //every byte plus EOF
+
+/*
+ * Orders leaves by count, breaking ties by character so that builds are deterministic.
+ */
+static bool leafLess(const HuffmanPoolNode& a, const HuffmanPoolNode& b) {
+    if (a.count != b.count) return a.count < b.count;
+    return a.character < b.character;
+}
+
+HuffmanPool::HuffmanPool() {
+    myCapacity = 2 * INITIAL_LEAF_CAPACITY - 1;
+    myNodes = new HuffmanPoolNode[myCapacity];
+    myDepths = new int[myCapacity];
+    mySize = 0;
+    myNumLeaves = 0;
+}
+
+HuffmanPool::~HuffmanPool() {
+    delete[] myNodes;
+    delete[] myDepths;
+}
+
+/*
+ * Grows the arrays if a tree with the given number of leaves (2N-1 nodes) won't fit.
+ * The old tree is thrown away, since this is only called at the start of a build.
+ * Big-Oh: O(N) when it resizes, O(1) otherwise
+ */
+void HuffmanPool::checkResize(int numLeaves) {
+    int needed = 2 * numLeaves - 1;
+    if (needed > myCapacity) {
+        delete[] myNodes;
+        delete[] myDepths;
+        myCapacity = max(needed, 2 * myCapacity);
+        myNodes = new HuffmanPoolNode[myCapacity];
+        myDepths = new int[myCapacity];
+    }
+}
+
+/*
+ * Builds from a frequency table by copying its entries into the leaf slots.
+ * Big-Oh: O(NlogN)
+ * @freqTable: maps each character to its number of occurrences
+ */
+void HuffmanPool::build(const Map<int, int>& freqTable) {
+    checkResize(freqTable.size());
+    int numLeaves = 0;
+    for (int ch: freqTable) {
+        HuffmanPoolNode& leaf = myNodes[numLeaves++];
+        leaf.character = ch;
+        leaf.count = (uint64_t) freqTable[ch];
+        leaf.zero = -1;
+        leaf.one = -1;
+    }
+    mergeLeaves(numLeaves);
+}
+
+/*
+ * Builds from an array of counts, skipping characters that never occur.
+ * Big-Oh: O(NlogN)
+ * @counts: the number of occurrences of each character
+ * @numSymbols: the number of entries in counts
+ */
+void HuffmanPool::build(const uint64_t counts[], int numSymbols) {
+    checkResize(numSymbols);
+    int numLeaves = 0;
+    for (int ch = 0; ch < numSymbols; ch++) {
+        if (counts[ch] == 0) continue;
+        HuffmanPoolNode& leaf = myNodes[numLeaves++];
+        leaf.character = ch;
+        leaf.count = counts[ch];
+        leaf.zero = -1;
+        leaf.one = -1;
+    }
+    mergeLeaves(numLeaves);
+}
+
+/*
+ * The two-queue merge. Leaves sit sorted in myNodes[0 .. numLeaves); every merge takes the two
+ * smallest fronts (preferring leaves on ties, which keeps the tree shallow) and appends the new
+ * parent, so the internal-node queue is simply myNodes[numLeaves .. mySize).
+ * Big-Oh: O(NlogN) for the sort, O(N) for the merges
+ */
+void HuffmanPool::mergeLeaves(int numLeaves) {
+    sort(myNodes, myNodes + numLeaves, leafLess);
+    mySize = numLeaves;
+    myNumLeaves = numLeaves;
+    int nextLeaf = 0;
+    int nextInternal = numLeaves;
+    for (int merges = 0; merges < numLeaves - 1; merges++) {
+        int children[2];
+        for (int k = 0; k < 2; k++) { //take the smaller front of the two queues, twice
+            if (nextLeaf < numLeaves
+                    && (nextInternal == mySize || myNodes[nextLeaf].count <= myNodes[nextInternal].count)) {
+                children[k] = nextLeaf++;
+            } else {
+                children[k] = nextInternal++;
+            }
+        }
+        HuffmanPoolNode& parent = myNodes[mySize++];
+        parent.character = NOT_A_CHAR;
+        parent.count = myNodes[children[0]].count + myNodes[children[1]].count;
+        parent.zero = children[0];
+        parent.one = children[1];
+    }
+}
+
+void HuffmanPool::clear() {
+    mySize = 0;
+    myNumLeaves = 0;
+}
+
+bool HuffmanPool::isEmpty() const {
+    return mySize == 0;
+}
+
+int HuffmanPool::size() const {
+    return mySize;
+}
+
+/*
+ * The root is always the last node made (or the only leaf).
+ */
+int HuffmanPool::root() const {
+    return mySize - 1;
+}
+
+bool HuffmanPool::isLeaf(int index) const {
+    return myNodes[index].zero < 0;
+}
+
+const HuffmanPoolNode& HuffmanPool::node(int index) const {
+    return myNodes[index];
+}
+
+/*
+ * Children always have smaller indexes than their parents, so one pass from the root down
+ * the array assigns every node its depth without any recursion.
+ * Big-Oh: O(N)
+ * @lengths: where each character's code length is stored
+ * @numSymbols: the number of entries in lengths
+ */
+void HuffmanPool::codeLengths(int lengths[], int numSymbols) const {
+    for (int ch = 0; ch < numSymbols; ch++) {
+        lengths[ch] = 0;
+    }
+    if (mySize == 0) return;
+    if (mySize == 1) { //lone leaf still needs a one-bit code
+        if (myNodes[0].character < numSymbols) lengths[myNodes[0].character] = 1;
+        return;
+    }
+    myDepths[mySize - 1] = 0;
+    for (int i = mySize - 1; i >= 0; i--) {
+        if (isLeaf(i)) {
+            if (myNodes[i].character < numSymbols) lengths[myNodes[i].character] = myDepths[i];
+        } else {
+            myDepths[myNodes[i].zero] = myDepths[i] + 1;
+            myDepths[myNodes[i].one] = myDepths[i] + 1;
+        }
+    }
+}
+
+/*
+ * Uses the tree's own depths when they fit in maxLength and falls back to package-merge otherwise.
+ * Big-Oh: O(N) for a shallow tree, O(N * maxLength) otherwise
+ * @lengths: where each character's code length is stored
+ * @numSymbols: the number of entries in lengths
+ * @maxLength: the longest code allowed
+ */
+void HuffmanPool::codeLengths(int lengths[], int numSymbols, int maxLength) const {
+    codeLengths(lengths, numSymbols);
+    int longest = 0;
+    for (int i = 0; i < myNumLeaves; i++) {
+        if (myNodes[i].character < numSymbols) longest = max(longest, lengths[myNodes[i].character]);
+    }
+    if (longest <= maxLength) return;
+    if (maxLength < 1 || maxLength > 30 || myNumLeaves > (1 << maxLength)) {
+        error("HuffmanPool::codeLengths: too many characters for the code length limit");
+    }
+
+    int* leafLengths = new int[myNumLeaves];
+    packageMerge(leafLengths, maxLength);
+    for (int i = 0; i < myNumLeaves; i++) {
+        if (myNodes[i].character < numSymbols) lengths[myNodes[i].character] = leafLengths[i];
+    }
+    delete[] leafLengths;
+}
+
+/*
+ * The package-merge (coin collector) algorithm. Think of each leaf as a coin of width 2^-d for
+ * every depth d from 1 to maxLength; choosing the 2N-2 cheapest coins that add up to N-1 gives the
+ * optimal length-limited code, where a leaf's length is the number of its coins chosen.
+ * Working up from the deepest level, each level's list is the sorted leaves merged with
+ * "packages" made by pairing up the previous level's list. Then, going back down, choosing the
+ * first m items of a level chooses the cheapest leaves in it plus some packages, and those
+ * packages are exactly the first 2 * (number of packages) items of the next level. So only a
+ * flag per item (leaf or package) has to be kept for each level.
+ * Big-Oh: O(N * maxLength)
+ * @leafLengths: where the code length of each (sorted) leaf is stored
+ * @maxLength: the longest code allowed
+ */
+void HuffmanPool::packageMerge(int leafLengths[], int maxLength) const {
+    int n = myNumLeaves;
+    int listCapacity = 2 * n;
+    bool* isPackage = new bool[maxLength * listCapacity]; //level d's flags start at (d - 1) * listCapacity
+    int* listSize = new int[maxLength];
+    uint64_t* previous = new uint64_t[listCapacity];
+    uint64_t* current = new uint64_t[listCapacity];
+
+    //deepest level: just the leaves
+    for (int i = 0; i < n; i++) {
+        previous[i] = myNodes[i].count;
+        isPackage[(maxLength - 1) * listCapacity + i] = false;
+    }
+    listSize[maxLength - 1] = n;
+
+    for (int level = maxLength - 1; level >= 1; level--) {
+        bool* flags = isPackage + (level - 1) * listCapacity;
+        int numPackages = listSize[level] / 2;
+        int leaf = 0;
+        int package = 0;
+        int size = 0;
+        while (leaf < n || package < numPackages) { //merge leaves with packages, leaves first on ties
+            uint64_t packageWeight = 0;
+            if (package < numPackages) packageWeight = previous[2 * package] + previous[2 * package + 1];
+            if (leaf < n && (package == numPackages || myNodes[leaf].count <= packageWeight)) {
+                current[size] = myNodes[leaf++].count;
+                flags[size++] = false;
+            } else {
+                current[size] = packageWeight;
+                flags[size++] = true;
+                package++;
+            }
+        }
+        listSize[level - 1] = size;
+        swap(previous, current);
+    }
+
+    for (int i = 0; i < n; i++) {
+        leafLengths[i] = 0;
+    }
+    int chosen = 2 * n - 2;
+    for (int level = 1; level <= maxLength && chosen > 0; level++) {
+        const bool* flags = isPackage + (level - 1) * listCapacity;
+        int leaves = 0;
+        for (int i = 0; i < chosen; i++) {
+            if (!flags[i]) leaves++;
+        }
+        for (int i = 0; i < leaves; i++) { //the cheapest leaves are the ones chosen at this level
+            leafLengths[i]++;
+        }
+        chosen = 2 * (chosen - leaves);
+    }
+
+    delete[] isPackage;
+    delete[] listSize;
+    delete[] previous;
+    delete[] current;
+}
+
+HuffmanNode* HuffmanPool::toHuffmanNodes() const {
+    if (mySize == 0) return NULL;
+    return copyNode(root());
+}
+
+HuffmanNode* HuffmanPool::copyNode(int index) const {
+    const HuffmanPoolNode& curr = myNodes[index];
+    if (isLeaf(index)) {
+        return new HuffmanNode(curr.character, (int) curr.count);
+    }
+    return new HuffmanNode(NOT_A_CHAR, (int) curr.count, copyNode(curr.zero), copyNode(curr.one));
+}
@@ -0,0 +1,92 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the HuffmanPool.h file which declares an array-based Huffman tree. All of the nodes
+ * of a tree live in one contiguous array and refer to their children by index, so a tree is
+ * built without any new/delete per node and "freeing" it just resets a size. One pool is
+ * meant to be reused for every tree a compressor builds (e.g. one per block).
+ */
+
+#ifndef _huffmanpool_h
+#define _huffmanpool_h
+
+#include <cstdint>
+#include "HuffmanNode.h"
+#include "map.h"
+using namespace std;
+
+/* Type: HuffmanPoolNode
+ * A node inside a HuffmanPool. Leaves have a character and no children (-1);
+ * internal nodes have NOT_A_CHAR and the pool indexes of their 0 and 1 subtrees.
+ */
+struct HuffmanPoolNode {
+    int character;   // character being represented by this node
+    uint64_t count;  // number of occurrences of the characters in this subtree
+    int zero;        // index of the 0 (left) subtree, -1 for a leaf
+    int one;         // index of the 1 (right) subtree, -1 for a leaf
+};
+
+class HuffmanPool {
+public:
+    HuffmanPool();
+    ~HuffmanPool();
+
+    /*
+     * Replaces the pool's tree with a Huffman tree for the given frequency table.
+     */
+    void build(const Map<int, int>& freqTable);
+
+    /*
+     * Replaces the pool's tree with a Huffman tree over the characters 0 .. numSymbols-1
+     * whose counts are nonzero.
+     */
+    void build(const uint64_t counts[], int numSymbols);
+
+    /*
+     * Discards the current tree (the node array is kept for the next build).
+     */
+    void clear();
+
+    bool isEmpty() const;
+    int size() const;                              // number of nodes in the tree
+    int root() const;                              // index of the root node, -1 if empty
+    bool isLeaf(int index) const;
+    const HuffmanPoolNode& node(int index) const;
+
+    /*
+     * Stores the depth of each character's leaf (its code length) in lengths[0 .. numSymbols-1],
+     * and 0 for characters that are not in the tree. A tree with a single leaf gives that
+     * character length 1 so that it still has a code.
+     */
+    void codeLengths(int lengths[], int numSymbols) const;
+
+    /*
+     * Same as codeLengths, but no code may be longer than maxLength bits. If the tree is already
+     * shallow enough its depths are used as is; otherwise the lengths come from the package-merge
+     * algorithm, which gives the cheapest set of codes that obeys the limit.
+     * Throws an error if there are more than 2^maxLength characters.
+     */
+    void codeLengths(int lengths[], int numSymbols, int maxLength) const;
+
+    /*
+     * Returns a copy of the tree built out of new'd HuffmanNodes, for use with the
+     * pointer-based functions in encoding.h. The caller frees it with freeTree.
+     */
+    HuffmanNode* toHuffmanNodes() const;
+
+private:
+    HuffmanPool(const HuffmanPool& other);            // not copyable (owns its arrays)
+    HuffmanPool& operator =(const HuffmanPool& other);
+
+    void checkResize(int numLeaves); //makes sure the arrays can hold a tree with that many leaves
+    void mergeLeaves(int numLeaves); //sorts the leaves and runs the two-queue merge
+    HuffmanNode* copyNode(int index) const; //recursive helper for toHuffmanNodes
+    void packageMerge(int lengths[], int maxLength) const; //length-limited code lengths of the leaves
+
+    HuffmanPoolNode* myNodes; //leaves first, then internal nodes in the order they were made
+    int* myDepths; //scratch space for codeLengths
+    int mySize; //number of nodes in the tree
+    int myNumLeaves; //number of leaves (they are stored sorted by count at the front of myNodes)
+    int myCapacity; //actual size of the arrays
+};
+
+#endif
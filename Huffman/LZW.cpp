@@ -1,104 +1,380 @@
-/*
- * Authors: Philip Clark and Susannah Meyer
- * Description: This bonus program is an implementation of the LZW compression algorithim. It takes in a user's string
- * as input, converts it using the compression algorithim into a coded series of numbers (which it prints), and
- * then uses the decompression algorithim to convert it back out into the original input.
- * Date: 11/18/15
- */
-
-#include "LZW.h"
-#include "pqueue.h"
-#include "filelib.h"
-#include "vector.h"
-#include "map.h"
-#include "console.h"
-#include "simpio.h"
-using namespace std;
-
-/*
- * The compress function takes a string and compresses in into a coded vector of ints.
- * The algorithim works by creating a baseline dictionary and then expanding it by
- * taking the longest part of the uncompressed string found in the dictionary
- * and using the dictionary value to encode it or creating a new dictionary entry with
- * the corresponding code.
- * @uncompressed: the input being compressed
- */
-Vector<int> compress (string uncompressed) {
-    Map<string, int> dict; //dictionary map which takes string values to a code
-    for (int i = 0; i < 256; ++i) { //creates dictionary of all possible string values
-        dict[charToString(char(i))]+=i;
-    }
-    string w;
-    Vector<int> compressed; //the ints which will make up the code
-
-    for (int i = 0; i < uncompressed.length(); ++i) { //for every character in the input string
-        string wc = w + uncompressed[i]; //the current string + the new character
-        if(dict.containsKey(wc)) { //if it's already in the dictionary make w the exapnded string described above
-            w = wc;
-        }
-        else {
-            compressed.add(dict[w]); //otherwise add it to the dictionary with the character code
-            dict[wc]+=dict.size(); //make a new dictionary entry with the expanded string
-            w = uncompressed[i]; //make w the character (need to start checking a new string)
-        }
-    }
-
-    if(w != "") { //if there is anything remaining in w, make it the final part of the code
-       compressed.add(dict[w]);
-    }
-
-    return compressed;
-}
-
-/*
- * The decompress method takes an encoded string represented by a vector of integers and
- * uses a reverse dictionary and a roughly analogous process to the compress method to
- * convert this code back into the original string.
- * @compressed: the encoded string
- */
-string decompress (Vector<int> compressed) {
-    Map<int, string> dict;
-    for (int i = 0; i < 256; ++i) { //make reverse dictionary (opposite of first step of compress)
-        dict[i]+=charToString(char(i));
-    }
-
-    string w = dict[compressed[0]]; //take out the first int of the encoded string
-    compressed.remove(0);
-    string decompressed = w; //set the first code value to w
-
-    for (int i: compressed) { //for every code value of the encoded string
-        string entry;
-        if(dict.containsKey(i)) { //if the reverse dictionary has the code, create the corresponding string
-            entry = dict[i];
-        }
-        else if (i == dict.size()) { //otherwise if its the next added value, make it the current w + the first character of w
-            entry = w + w[0];
-        }
-        decompressed+=entry; //add next part of string to decompressed string
-        dict[dict.size()]+=w+entry[0]; //add new value to expand the reverse dictionary
-
-        w = entry;
-    }
-
-    return decompressed;
-}
-
-/*
- * The main method the bonus LZW algorithim allows the user to input a string (or press q
- * for quitting) and then prints output that shows the encoding and decodign process.
- */
-int main2() {
-    ifstream in;
-    while(true) {
-        cout << "Welcome to the LZW bonus compression algorithim!" << endl;
-        string input = getLine("Please input a string to be compressed. Enter q to quit.");
-        if(input == "q") break;
-        Vector<int> compressed = compress(input);
-        string decompressed = decompress(compressed);
-        cout << "\""<< input << "\" gets converted to " << compressed << " and back to \""
-             << decompressed << "\"\n" << endl;
-    }
-
-    return 0;
-}
-
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This bonus program is an implementation of the LZW compression algorithim. It takes in a user's string
+ * as input, converts it using the compression algorithim into a coded series of numbers (which it prints), and
+ * then uses the decompression algorithim to convert it back out into the original input.
+ * The streaming codec (compressLZW/decompressLZW) does the same work on files: the encoder keeps its
+ * dictionary in a hash table keyed on (prefix code, next byte), so each input byte costs one probe
+ * instead of building and looking up a string, and the decoder keeps each code as its prefix code
+ * and last byte and unrolls the chain into a scratch buffer. Both dictionaries have a fixed size and are
+ * emptied with a clear code (see LZW.h).
+ * Date: 11/18/15
+ */
+
+#include "LZW.h"
+#include <cstdint>
+#include <cstring>
+#include "BitIO.h"
+#include "error.h"
+#include "pqueue.h"
+#include "strlib.h"
+#include "filelib.h"
+#include "vector.h"
+#include "map.h"
+#include "console.h"
+#include "simpio.h"
+using namespace std;
+
+static const char LZW_MAGIC[] = "HLZW";
+static const int LZW_VERSION = 1;
+static const int LZW_HEADER_BYTES = 6;
+static const int LZW_BUFFER_BYTES = 1 << 16; //bytes read or written at a time
+
+/*
+ * Returns the code width to use while highestCode is the largest code that could be sent next.
+ * The encoder and decoder each work this out from their own dictionary size, so they stay in step.
+ */
+static int codeWidth(int highestCode, int maxBits) {
+    int bits = LZW_MIN_BITS;
+    while (bits < maxBits && highestCode >= (1 << bits)) {
+        bits++;
+    }
+    return bits;
+}
+
+/*
+ * The encoder's dictionary: an open-addressing hash table from (prefix code, next byte) pairs to the
+ * code of the string they make. The table has twice as many slots as the largest dictionary, so probe
+ * sequences stay short.
+ */
+class LZWDictionary {
+public:
+    LZWDictionary(int maxBits) {
+        myTableBits = maxBits + 1;
+        myKeys = new uint32_t[1 << myTableBits];
+        myCodes = new uint16_t[1 << myTableBits];
+        clear();
+    }
+
+    ~LZWDictionary() {
+        delete[] myKeys;
+        delete[] myCodes;
+    }
+
+    /*
+     * Empties the dictionary.
+     */
+    void clear() {
+        memset(myKeys, 0, sizeof(uint32_t) << myTableBits);
+    }
+
+    /*
+     * Returns the code for prefix followed by ch if the dictionary has it. Otherwise adds it with
+     * the code newCode (unless newCode is -1, meaning the dictionary is full) and returns -1.
+     */
+    int findOrAdd(int prefix, int ch, int newCode) {
+        uint32_t key = ((uint32_t) prefix << 8 | ch) + 1; //0 marks an empty slot
+        uint32_t mask = (1 << myTableBits) - 1;
+        uint32_t slot = (key * 2654435761u) >> (32 - myTableBits);
+        while (myKeys[slot] != 0) {
+            if (myKeys[slot] == key) return myCodes[slot];
+            slot = (slot + 1) & mask;
+        }
+        if (newCode >= 0) {
+            myKeys[slot] = key;
+            myCodes[slot] = (uint16_t) newCode;
+        }
+        return -1;
+    }
+
+private:
+    uint32_t* myKeys;   // (prefix << 8 | byte) + 1 for each used slot, 0 for empty ones
+    uint16_t* myCodes;  // the code of each used slot's string
+    int myTableBits;
+
+    LZWDictionary(const LZWDictionary&); //not copyable
+    LZWDictionary& operator =(const LZWDictionary&);
+};
+
+/*
+ * Reads the input a chunk at a time, extending the current match one byte at a time through the
+ * dictionary and sending its code when it can't be extended any further. Once the dictionary is
+ * full, every LZW_CHECK_BYTES of input the ratio so far is compared with the best one seen since
+ * the last reset; if it got worse, the dictionary is cleared.
+ * @input: where the data is being encoded from
+ * @output: where the codes are being written to
+ * @maxBits: the widest code to use
+ */
+void compressLZW(istream& input, obitstream& output, int maxBits) {
+    if (maxBits < LZW_MIN_BITS || maxBits > LZW_MAX_BITS) {
+        error("compressLZW: maximum code width must be between " + integerToString(LZW_MIN_BITS)
+              + " and " + integerToString(LZW_MAX_BITS));
+    }
+    output.write(LZW_MAGIC, 4);
+    output.put((char) LZW_VERSION);
+    output.put((char) maxBits);
+
+    LZWDictionary dict(maxBits);
+    BitWriter writer(output);
+    int maxCode = 1 << maxBits;
+    int nextCode = LZW_FIRST_CODE;
+    int prefix = -1; //code of the current match, -1 before the first byte
+    uint64_t bytesIn = 0;
+    uint64_t nextCheck = LZW_CHECK_BYTES;
+    double bestRatio = 0;
+    char* buffer = new char[LZW_BUFFER_BYTES];
+    while (input.read(buffer, LZW_BUFFER_BYTES) || input.gcount() > 0) {
+        const unsigned char* bytes = (const unsigned char*) buffer;
+        int length = (int) input.gcount();
+        int i = 0;
+        if (prefix < 0) prefix = bytes[i++];
+        for (; i < length; i++) {
+            int code = dict.findOrAdd(prefix, bytes[i], nextCode < maxCode ? nextCode : -1);
+            if (code >= 0) { //the match goes on
+                prefix = code;
+            } else {
+                writer.writeBits(prefix, codeWidth(nextCode - 1, maxBits));
+                prefix = bytes[i];
+                if (nextCode < maxCode) {
+                    nextCode++;
+                } else if (bytesIn + i >= nextCheck) {
+                    nextCheck = bytesIn + i + LZW_CHECK_BYTES;
+                    double ratio = (double) (bytesIn + i) / writer.bitsWritten();
+                    if (ratio >= bestRatio) {
+                        bestRatio = ratio;
+                    } else { //the dictionary has stopped fitting the data
+                        writer.writeBits(LZW_CLEAR, maxBits);
+                        dict.clear();
+                        nextCode = LZW_FIRST_CODE;
+                        bestRatio = 0;
+                    }
+                }
+            }
+        }
+        bytesIn += length;
+    }
+    delete[] buffer;
+    if (prefix >= 0) writer.writeBits(prefix, codeWidth(nextCode - 1, maxBits));
+    writer.writeBits(LZW_EOF, codeWidth(nextCode, maxBits)); //the decoder has added one more entry by now
+    writer.flush();
+}
+
+/*
+ * The decoder's dictionary: each code is stored as its prefix code and last byte, exactly the
+ * pairs the encoder hashed. A code's string is produced by following its prefix codes back to a
+ * single byte, filling a reusable scratch buffer from the end, so decoding a code costs time
+ * proportional to its length with no allocation or string copies.
+ */
+class LZWDecoder {
+public:
+    LZWDecoder(int maxBits) {
+        myMaxBits = maxBits;
+        myMaxCode = 1 << maxBits;
+        myPrefixes = new uint16_t[myMaxCode];
+        mySuffixes = new unsigned char[myMaxCode];
+        myScratch = new unsigned char[myMaxCode]; //no string is longer than the dictionary
+        reset();
+    }
+
+    ~LZWDecoder() {
+        delete[] myPrefixes;
+        delete[] mySuffixes;
+        delete[] myScratch;
+    }
+
+    /*
+     * Empties the dictionary, as when LZW_CLEAR is read.
+     */
+    void reset() {
+        myNextCode = LZW_FIRST_CODE;
+        myPrevious = -1;
+    }
+
+    /*
+     * Returns the width of the next code. The encoder has always added one entry more than the
+     * decoder at this point, hence myNextCode rather than myNextCode - 1.
+     */
+    int nextWidth() const {
+        return codeWidth(myNextCode, myMaxBits);
+    }
+
+    /*
+     * Decodes a code (other than LZW_EOF and LZW_CLEAR) and adds the dictionary entry it completes.
+     * Sets start to the code's bytes, which stay valid until the next call, and returns their number,
+     * or returns -1 if the code can't appear here.
+     */
+    int decode(int code, const unsigned char*& start) {
+        if (code < 0 || code > myNextCode || code == myMaxCode || (myPrevious < 0 && code >= LZW_EOF)) {
+            return -1;
+        }
+        unsigned char* end = myScratch + myMaxCode;
+        unsigned char* p = end;
+        int chain = code;
+        if (code == myNextCode) { //the string being defined right now: previous + its own first byte
+            --p; //filled in below
+            chain = myPrevious;
+        }
+        while (chain >= LZW_FIRST_CODE) {
+            *--p = mySuffixes[chain];
+            chain = myPrefixes[chain];
+        }
+        *--p = (unsigned char) chain;
+        if (code == myNextCode) end[-1] = *p;
+
+        if (myPrevious >= 0 && myNextCode < myMaxCode) {
+            myPrefixes[myNextCode] = (uint16_t) myPrevious;
+            mySuffixes[myNextCode] = *p;
+            myNextCode++;
+        }
+        myPrevious = code;
+        start = p;
+        return (int) (end - p);
+    }
+
+private:
+    uint16_t* myPrefixes;     // prefix code of each dictionary string
+    unsigned char* mySuffixes; // last byte of each dictionary string
+    unsigned char* myScratch; // where strings are unrolled, back to front
+    int myMaxBits;
+    int myMaxCode;
+    int myNextCode;           // code the next dictionary entry will get
+    int myPrevious;           // last code decoded, -1 right after a reset
+
+    LZWDecoder(const LZWDecoder&); //not copyable
+    LZWDecoder& operator =(const LZWDecoder&);
+};
+
+/*
+ * Reads codes until LZW_EOF, rebuilding the encoder's dictionary one step behind it, and copies
+ * each code's bytes into a chunk buffer that is written out when full.
+ * @input: where the codes are being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressLZW(ibitstream& input, ostream& output) {
+    unsigned char header[LZW_HEADER_BYTES];
+    input.read((char*) header, LZW_HEADER_BYTES);
+    if (input.gcount() != LZW_HEADER_BYTES || memcmp(header, LZW_MAGIC, 4) != 0) {
+        error("decompressLZW: not an LZW-compressed stream");
+    }
+    int maxBits = header[5];
+    if (header[4] != LZW_VERSION || maxBits < LZW_MIN_BITS || maxBits > LZW_MAX_BITS) {
+        error("decompressLZW: unsupported LZW stream");
+    }
+
+    LZWDecoder decoder(maxBits);
+    BitReader reader(input);
+    char* buffer = new char[LZW_BUFFER_BYTES];
+    int buffered = 0;
+    bool ok = true;
+    while (true) {
+        int64_t code = reader.readBits(decoder.nextWidth());
+        if (code == LZW_EOF) break;
+        if (code == LZW_CLEAR) {
+            decoder.reset();
+            continue;
+        }
+        const unsigned char* start;
+        int length = decoder.decode((int) code, start);
+        if (length < 0) {
+            ok = false;
+            break;
+        }
+        if (buffered + length > LZW_BUFFER_BYTES) {
+            output.write(buffer, buffered);
+            buffered = 0;
+        }
+        if (length > LZW_BUFFER_BYTES) {
+            output.write((const char*) start, length);
+        } else {
+            memcpy(buffer + buffered, start, length);
+            buffered += length;
+        }
+    }
+    output.write(buffer, buffered);
+    delete[] buffer;
+    if (!ok) error("decompressLZW: compressed data is corrupt or truncated");
+}
+
+/*
+ * The compress function takes a string and compresses in into a coded vector of ints.
+ * The algorithim works by creating a baseline dictionary and then expanding it by
+ * taking the longest part of the uncompressed string found in the dictionary
+ * and using the dictionary value to encode it or creating a new dictionary entry with
+ * the corresponding code. Single characters are their own codes, and each longer string is
+ * stored as the code of its prefix plus its last character. When the dictionary is full
+ * it sends LZW_CLEAR and starts over.
+ * @uncompressed: the input being compressed
+ */
+Vector<int> compress (string uncompressed) {
+    LZWDictionary dict(LZW_MAX_BITS); //dictionary which takes (prefix code, character) pairs to a code
+    int maxCode = 1 << LZW_MAX_BITS;
+    int nextCode = LZW_FIRST_CODE;
+    Vector<int> compressed; //the ints which will make up the code
+    if (uncompressed.empty()) return compressed;
+
+    int w = (unsigned char) uncompressed[0]; //code of the current string
+    for (int i = 1; i < uncompressed.length(); ++i) { //for every character in the input string
+        unsigned char c = uncompressed[i];
+        int wc = dict.findOrAdd(w, c, nextCode); //the current string + the new character
+        if(wc >= 0) { //if it's already in the dictionary make w the exapnded string described above
+            w = wc;
+        }
+        else { //otherwise output w (findOrAdd has made a new dictionary entry with the expanded string)
+            compressed.add(w);
+            nextCode++;
+            if (nextCode == maxCode) { //dictionary is full, start over
+                compressed.add(LZW_CLEAR);
+                dict.clear();
+                nextCode = LZW_FIRST_CODE;
+            }
+            w = c; //make w the character (need to start checking a new string)
+        }
+    }
+    compressed.add(w); //whatever remains in w is the final part of the code
+
+    return compressed;
+}
+
+/*
+ * The decompress method takes an encoded string represented by a vector of integers and
+ * uses a reverse dictionary and a roughly analogous process to the compress method to
+ * convert this code back into the original string. The reverse dictionary is the same
+ * LZWDecoder the streaming codec uses, so each code's characters are appended straight
+ * onto the result.
+ * @compressed: the encoded string
+ */
+string decompress (const Vector<int>& compressed) {
+    LZWDecoder dict(LZW_MAX_BITS);
+    string decompressed;
+    for (int code: compressed) { //for every code value of the encoded string
+        if (code == LZW_CLEAR) { //start over with an empty dictionary
+            dict.reset();
+            continue;
+        }
+        const unsigned char* entry;
+        int length = dict.decode(code, entry); //also adds the new value to the reverse dictionary
+        if (length < 0) error("decompress: invalid LZW code");
+        decompressed.append((const char*) entry, length);
+    }
+    return decompressed;
+}
+
+/*
+ * The main method the bonus LZW algorithim allows the user to input a string (or press q
+ * for quitting) and then prints output that shows the encoding and decodign process.
+ */
+int main2() {
+    ifstream in;
+    while(true) {
+        cout << "Welcome to the LZW bonus compression algorithim!" << endl;
+        string input = getLine("Please input a string to be compressed. Enter q to quit.");
+        if(input == "q") break;
+        Vector<int> compressed = compress(input);
+        string decompressed = decompress(compressed);
+        cout << "\""<< input << "\" gets converted to " << compressed << " and back to \""
+             << decompressed << "\"\n" << endl;
+    }
+
+    return 0;
+}
+
@@ -1,36 +1,53 @@
-///*
-// * CS 106B Huffman Encoding
-// * This file declares the functions that you will need to write in this
-// * assignment for your Huffman Encoder in huffmanencoding.cpp.
-// *
-// * Please do not modify this provided file. Your turned-in files should work
-// * with an unmodified version of all provided code files.
-// *
-// * Author : Marty Stepp
-// * Version: Thu 2013/11/14
-// */
-
-//#ifndef _LZW_h
-//#define _LZW_h
-
-//#include <iostream>
-//#include <string>
-//#include "bitstream.h"
-//#include "HuffmanNode.h"
-//#include "map.h"
-//using namespace std;
-
-///*
-//// * See huffmanencoding.cpp for documentation of these functions
-// * (which you are supposed to write, based on the spec).
-// */
-//Map<int, int> buildFrequencyTable(istream& input);
-//HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable);
-//Map<int, string> buildEncodingMap(HuffmanNode* encodingTree);
-//void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output);
-//void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output);
-//void compress(istream& input, obitstream& output);
-//void decompress(ibitstream& input, ostream& output);
-//void freeTree(HuffmanNode* node);
-
-//#endif
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the LZW.h file which declares the LZW compressor. compressLZW/decompressLZW are the
+ * streaming codec: the dictionary maps (prefix code, next byte) pairs to codes, and codes are
+ * written to the bit stream at a width that grows from LZW_MIN_BITS to the stream's maximum as
+ * the dictionary fills. The dictionary never grows past 2^maxBits codes, so memory stays fixed
+ * however long the input is; once it is full the encoder watches the compression ratio and, when
+ * it starts to drop (the data has changed and the old strings no longer match), sends LZW_CLEAR and
+ * both sides start over with an empty dictionary, like Unix compress.
+ * compress/decompress are the bonus demo that shows the codes as a vector.
+ *
+ * Stream layout: "HLZW", version byte, maximum code width byte, then the codes (first bit lowest),
+ * ending with LZW_EOF.
+ */
+
+#ifndef _LZW_h
+#define _LZW_h
+
+#include <iostream>
+#include <string>
+#include "bitstream.h"
+#include "vector.h"
+using namespace std;
+
+const int LZW_MIN_BITS = 9;       // codes start out 9 bits wide
+const int LZW_MAX_BITS = 16;      // widest code a stream may use
+const int LZW_EOF = 256;          // code that ends the stream
+const int LZW_CLEAR = 257;        // code that empties the dictionary
+const int LZW_FIRST_CODE = 258;   // first code given to a dictionary string
+const int LZW_CHECK_BYTES = 10000;  // input between ratio checks once the dictionary is full
+
+/*
+ * Compresses the input with LZW, reading and writing in chunks so any size of input can be
+ * streamed. maxBits (LZW_MIN_BITS to LZW_MAX_BITS) sets the largest dictionary, 2^maxBits codes;
+ * the encoder then needs about 2^(maxBits+4) bytes and the decoder 2^(maxBits+2).
+ */
+void compressLZW(istream& input, obitstream& output, int maxBits = LZW_MAX_BITS);
+
+/*
+ * Decompresses a stream written by compressLZW. Throws an error if the data is not an LZW
+ * stream or is damaged.
+ */
+void decompressLZW(ibitstream& input, ostream& output);
+
+/*
+ * The bonus demo: compress turns a string into the list of codes LZW would send, and
+ * decompress turns such a list back into the string. Like the streaming codec, the dictionary
+ * holds at most 2^LZW_MAX_BITS codes; the demo simply sends LZW_CLEAR whenever it fills up.
+ */
+Vector<int> compress(string uncompressed);
+string decompress(const Vector<int>& compressed);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the MappedFile class. Files are mapped read-only with mmap
+ * and advised for sequential access, so a compression pass over the bytes is limited by the page
+ * cache rather than by per-character stream calls. Platforms without mmap read the file into one
+ * buffer instead.
+ */
+
+#include "MappedFile.h"
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+    myData = NULL;
+    mySize = 0;
+    myIsOpen = false;
+    myIsMapped = false;
+}
+
+MappedFile::MappedFile(string filename) {
+    myData = NULL;
+    mySize = 0;
+    myIsOpen = false;
+    myIsMapped = false;
+    open(filename);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+/*
+ * Opens the file and maps the whole thing. Empty files can't be mapped, so they are
+ * simply recorded as open with a size of zero.
+ * @filename: the file to map
+ */
+bool MappedFile::open(string filename) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    mySize = (size_t) info.st_size;
+    if (mySize > 0) {
+        void* mapped = mmap(NULL, mySize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            mySize = 0;
+            return false;
+        }
+        madvise(mapped, mySize, MADV_SEQUENTIAL); //we read front to back, so let the kernel read ahead
+        myData = (const unsigned char*) mapped;
+        myIsMapped = true;
+    }
+    ::close(fd); //the mapping stays valid after the descriptor is closed
+#else
+    ifstream input;
+    input.open(filename.c_str(), ifstream::binary);
+    if (input.fail()) return false;
+    input.seekg(0, ifstream::end);
+    mySize = (size_t) input.tellg();
+    input.seekg(0, ifstream::beg);
+    if (mySize > 0) {
+        char* buffer = new char[mySize];
+        input.read(buffer, mySize);
+        myData = (const unsigned char*) buffer;
+    }
+#endif
+    myIsOpen = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (myData != NULL) {
+#ifndef _WIN32
+        if (myIsMapped) munmap((void*) myData, mySize);
+        else delete[] (char*) myData;
+#else
+        delete[] (char*) myData;
+#endif
+    }
+    myData = NULL;
+    mySize = 0;
+    myIsOpen = false;
+    myIsMapped = false;
+}
+
+bool MappedFile::isOpen() const {
+    return myIsOpen;
+}
+
+const unsigned char* MappedFile::data() const {
+    return myData;
+}
+
+size_t MappedFile::size() const {
+    return mySize;
+}
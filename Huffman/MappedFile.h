@@ -0,0 +1,65 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the MappedFile.h file which declares a read-only view of a whole file's bytes.
+ * On POSIX systems the file is mmap'ed so that callers can scan it directly without
+ * copying it through an istream one character at a time; elsewhere it falls back to
+ * reading the file into a single heap buffer.
+ */
+
+#ifndef _mappedfile_h
+#define _mappedfile_h
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
+class MappedFile {
+public:
+    /*
+     * Constructs a closed MappedFile, or one that immediately opens the given file.
+     */
+    MappedFile();
+    MappedFile(string filename);
+
+    /*
+     * Unmaps/frees the file's bytes if they are still open.
+     */
+    ~MappedFile();
+
+    /*
+     * Maps the given file into memory, closing any file that was already open.
+     * Returns true if the file's bytes are now available through data().
+     */
+    bool open(string filename);
+
+    /*
+     * Releases the file's bytes; data() is invalid afterwards.
+     */
+    void close();
+
+    /*
+     * Returns true if a file is currently open.
+     */
+    bool isOpen() const;
+
+    /*
+     * Returns a pointer to the first byte of the file (NULL for an empty or closed file).
+     */
+    const unsigned char* data() const;
+
+    /*
+     * Returns the number of bytes in the file.
+     */
+    size_t size() const;
+
+private:
+    MappedFile(const MappedFile& other);            // not copyable (owns the mapping)
+    MappedFile& operator =(const MappedFile& other);
+
+    const unsigned char* myData; //first byte of the file
+    size_t mySize; //number of bytes in the file
+    bool myIsOpen; //whether a file is open
+    bool myIsMapped; //true if myData came from mmap, false if it is a heap buffer
+};
+
+#endif
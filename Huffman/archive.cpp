@@ -0,0 +1,599 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the archive declared in archive.h. Each batch of files goes
+ * through four steps: map the files and count the small ones' bytes (in parallel), build one
+ * shared code per extension from the summed counts (cheap, so on one thread), code every file
+ * (in parallel), and write the tables and payloads in order while noting their offsets for the
+ * directory. Shared codes are built from counts with one added to every character, so any byte
+ * of any file in the group has a code. Reading maps the archive and decodes straight out of the
+ * mapping, so entries can be extracted on any number of threads without locking.
+ */
+
+#include "archive.h"
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "bytes.h"
+#include "checksum.h"
+#include "error.h"
+#include "filelib.h"
+#include "histogram.h"
+#include "strlib.h"
+
+static const char ARCHIVE_MAGIC[] = "HARC";
+static const char DIRECTORY_MAGIC[] = "HARD";
+static const int ARCHIVE_VERSION = 1;
+static const int SHARED_MIN_FILES = 4;         //fewer files than this code themselves
+static const size_t MAX_NAME_BYTES = 0xffff;   //names are stored with a 16-bit length
+
+ArchiveOptions::ArchiveOptions() {
+    sharedMaxBytes = DEFAULT_SHARED_MAX_BYTES;
+    numThreads = max(1, (int) thread::hardware_concurrency());
+}
+
+/*
+ * Runs job(0) .. job(count - 1) on up to numThreads threads. Every job runs even if others fail;
+ * afterwards the failure of the lowest-numbered job that failed is rethrown.
+ */
+static void runParallel(int count, int numThreads, const function<void(int)>& job) {
+    Vector<exception_ptr> failures(count);
+    atomic<int> next(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next++) < count) {
+            try {
+                job(i);
+            } catch (...) {
+                failures[i] = current_exception();
+            }
+        }
+    };
+    Vector<thread*> threads;
+    for (int t = 1; t < min(numThreads, count); t++) {
+        threads.add(new thread(worker));
+    }
+    worker();
+    for (int t = 0; t < threads.size(); t++) {
+        threads[t]->join();
+        delete threads[t];
+    }
+    for (int i = 0; i < count; i++) {
+        if (failures[i]) rethrow_exception(failures[i]);
+    }
+}
+
+/*
+ * Returns name with '/' separators and without a leading "./" or "/".
+ * Throws an error for names that are empty, too long, or that would escape the directory they
+ * are extracted into (".." components).
+ */
+static string archiveName(const string& name) {
+    string result = name;
+    string separator = getDirectoryPathSeparator();
+    if (separator != "/") result = stringReplace(result, separator, "/");
+    while (startsWith(result, "./") || startsWith(result, "/")) {
+        result.erase(0, startsWith(result, "/") ? 1 : 2);
+    }
+    string components = "/" + result + "/";
+    if (result == "" || result.size() > MAX_NAME_BYTES || components.find("/../") != string::npos) {
+        error("archive: invalid entry name \"" + name + "\"");
+    }
+    return result;
+}
+
+/*
+ * A file of the batch being written.
+ */
+struct PendingEntry {
+    MappedFile file;
+    uint64_t counts[256];   // only counted for files that may share a table
+    int table;              // index of its shared table in the batch's tables, or -1
+    int method;
+    string payload;         // unused for ENTRY_STORED, whose payload is the file itself
+    uint32_t checksum;
+};
+
+/*
+ * A shared table being built for a batch.
+ */
+struct SharedTable {
+    uint32_t number;
+    int lengths[256];
+    uint32_t bits[256];
+};
+
+/*
+ * Appends data's blocks and an end marker to output, stopping early once output has grown by
+ * limit bytes (the result is then no use to the caller and is thrown away).
+ */
+static void encodeBlocks(const unsigned char* data, size_t size, const BlockOptions& options, size_t limit,
+                         string& output) {
+    size_t start = output.size();
+    for (size_t done = 0; done < size && output.size() - start < limit; done += options.blockSize) {
+        encodeBlock(data + done, min(size - done, (size_t) options.blockSize), options, output);
+    }
+    appendEndBlock(output);
+}
+
+/*
+ * Decodes the blocks written by encodeBlocks, which must decode to exactly size bytes.
+ * @what: what is being decoded, for error messages
+ */
+static void decodeBlocks(const unsigned char* payload, uint64_t payloadLength, int blockSize,
+                         unsigned char* output, uint64_t size, const string& what) {
+    uint64_t done = 0;
+    uint64_t remaining = payloadLength;
+    while (true) {
+        if (remaining < (uint64_t) BLOCK_HEADER_BYTES) error("ArchiveReader: " + what + " is truncated");
+        BlockHeader header;
+        parseBlockHeader(payload, header);
+        payload += BLOCK_HEADER_BYTES;
+        remaining -= BLOCK_HEADER_BYTES;
+        if (header.type == BLOCK_END) break;
+        if (header.rawLength > (uint32_t) blockSize || header.rawLength > size - done
+                || header.payloadLength > remaining) {
+            error("ArchiveReader: " + what + " is corrupt");
+        }
+        decodeBlock(header, payload, output + done);
+        done += header.rawLength;
+        payload += header.payloadLength;
+        remaining -= header.payloadLength;
+    }
+    if (done != size) error("ArchiveReader: " + what + " is corrupt");
+}
+
+/*
+ * Codes a file on its own: its blocks and an end marker, or the file as it is if that is smaller.
+ */
+static void encodeOwnEntry(PendingEntry& entry, const BlockOptions& options) {
+    size_t size = entry.file.size();
+    entry.method = ENTRY_STORED;
+    if (size == 0) return;
+    encodeBlocks(entry.file.data(), size, options, size, entry.payload);
+    if (entry.payload.size() < size) {
+        entry.method = ENTRY_BLOCKS;
+    } else {
+        string().swap(entry.payload);
+    }
+}
+
+/*
+ * Codes a file with its shared table.
+ */
+static void encodeSharedEntry(PendingEntry& entry, const SharedTable& table) {
+    entry.method = ENTRY_SHARED;
+    BitWriter writer(entry.payload);
+    const unsigned char* data = entry.file.data();
+    for (size_t i = 0; i < entry.file.size(); i++) {
+        writer.writeBits(table.bits[data[i]], table.lengths[data[i]]);
+    }
+    writer.flush();
+}
+
+/*
+ * Groups a batch's small files by extension and builds a table for every group with at least
+ * SHARED_MIN_FILES files. A file only uses its group's table if that codes it smaller than it is.
+ * @nextTable: the number the next new table gets; advanced past the tables built here
+ */
+static void buildSharedTables(Vector<PendingEntry*>& batch, const Vector<string>& names, int first,
+                              const ArchiveOptions& options, Vector<SharedTable*>& tables, uint32_t& nextTable) {
+    Map<string, Vector<int> > groups;
+    for (int i = 0; i < batch.size(); i++) {
+        size_t size = batch[i]->file.size();
+        if (size > 0 && size <= options.sharedMaxBytes) {
+            groups[toLowerCase(getExtension(names[first + i]))].add(i);
+        }
+    }
+    for (string extension : groups) {
+        const Vector<int>& members = groups[extension];
+        if (members.size() < SHARED_MIN_FILES) continue;
+        uint64_t counts[256];
+        for (int ch = 0; ch < 256; ch++) {
+            counts[ch] = 1;
+        }
+        for (int i : members) {
+            for (int ch = 0; ch < 256; ch++) {
+                counts[ch] += batch[i]->counts[ch];
+            }
+        }
+        SharedTable* table = new SharedTable;
+        HuffmanPool pool;
+        pool.build(counts, 256);
+        pool.codeLengths(table->lengths, 256, options.blockOptions.maxCodeLength);
+        HuffmanCode code;
+        code.build(table->lengths, 256);
+        for (int ch = 0; ch < 256; ch++) {
+            table->bits[ch] = code.bits(ch);
+        }
+        bool used = false;
+        for (int i : members) {
+            uint64_t bits = 0;
+            for (int ch = 0; ch < 256; ch++) {
+                bits += batch[i]->counts[ch] * table->lengths[ch];
+            }
+            if ((bits + 7) / 8 < batch[i]->file.size()) {
+                batch[i]->table = tables.size();
+                used = true;
+            }
+        }
+        if (used) {
+            table->number = nextTable++;
+            tables.add(table);
+        } else {
+            delete table;
+        }
+    }
+}
+
+/*
+ * Reads, codes and writes one batch of files, adding their entries and their tables' offsets.
+ * @first: the index of the batch's first file
+ * @position: the number of bytes written to output so far; advanced past the batch
+ */
+static void writeBatch(const Vector<string>& files, const Vector<string>& names, int first, int count,
+                       const ArchiveOptions& options, ostream& output, uint64_t& position,
+                       Vector<ArchiveEntry>& entries, Vector<uint64_t>& tableOffsets) {
+    Vector<PendingEntry*> batch;
+    for (int i = 0; i < count; i++) {
+        batch.add(new PendingEntry);
+        batch[i]->table = -1;
+    }
+    Vector<SharedTable*> tables;
+    try {
+        runParallel(count, options.numThreads, [&](int i) {
+            PendingEntry& entry = *batch[i];
+            if (!entry.file.open(files[first + i])) error("createArchive: cannot read " + files[first + i]);
+            memset(entry.counts, 0, sizeof(entry.counts));
+            if (entry.file.size() <= options.sharedMaxBytes) {
+                countBytes(entry.file.data(), entry.file.size(), entry.counts);
+            }
+        });
+        uint32_t nextTable = tableOffsets.size();
+        buildSharedTables(batch, names, first, options, tables, nextTable);
+        runParallel(count, options.numThreads, [&](int i) {
+            PendingEntry& entry = *batch[i];
+            if (entry.table >= 0) {
+                encodeSharedEntry(entry, *tables[entry.table]);
+            } else {
+                encodeOwnEntry(entry, options.blockOptions);
+            }
+            entry.checksum = 0;
+            if (options.blockOptions.checksummed && entry.method != ENTRY_BLOCKS) {
+                entry.checksum = crc32c(entry.file.data(), entry.file.size());
+            }
+        });
+
+        string encoded;
+        for (int t = 0; t < tables.size(); t++) {
+            tableOffsets.add(position + encoded.size());
+            writeCodeLengths(encoded, tables[t]->lengths);
+        }
+        output.write(encoded.data(), encoded.size());
+        position += encoded.size();
+        for (int i = 0; i < count; i++) {
+            PendingEntry& entry = *batch[i];
+            ArchiveEntry added;
+            added.name = names[first + i];
+            added.method = entry.method;
+            added.table = entry.table >= 0 ? tables[entry.table]->number : 0;
+            added.size = entry.file.size();
+            added.offset = position;
+            added.checksum = entry.checksum;
+            if (entry.method == ENTRY_STORED) {
+                output.write((const char*) entry.file.data(), entry.file.size());
+                added.payloadLength = entry.file.size();
+            } else {
+                output.write(entry.payload.data(), entry.payload.size());
+                added.payloadLength = entry.payload.size();
+            }
+            position += added.payloadLength;
+            entries.add(added);
+        }
+        if (!output) error("createArchive: could not write the output");
+    } catch (...) {
+        for (int i = 0; i < batch.size(); i++) delete batch[i];
+        for (int t = 0; t < tables.size(); t++) delete tables[t];
+        throw;
+    }
+    for (int i = 0; i < batch.size(); i++) delete batch[i];
+    for (int t = 0; t < tables.size(); t++) delete tables[t];
+}
+
+/*
+ * Writes the header, the batches, and then the directory and trailer.
+ * @files: the files to add
+ * @names: the name each file gets in the archive
+ * @output: where the archive is written
+ * @options: the compression settings
+ */
+void createArchive(const Vector<string>& files, const Vector<string>& names, ostream& output,
+                   const ArchiveOptions& options) {
+    if (files.size() != names.size()) error("createArchive: need one name per file");
+    if (options.numThreads < 1) error("ArchiveOptions: need at least one thread");
+    Vector<string> stored;
+    Map<string, int> seen; //a reader refuses an archive with the same name twice
+    for (int i = 0; i < names.size(); i++) {
+        string name = archiveName(names[i]);
+        if (seen.containsKey(name)) {
+            error("createArchive: " + names[seen[name]] + " and " + names[i] + " are both stored as " + name);
+        }
+        seen.put(name, i);
+        stored.add(name);
+    }
+    string encoded;
+    writeStreamHeader(encoded, options.blockOptions); //only to check the block options
+    encoded.assign(ARCHIVE_MAGIC, 4);
+    encoded += (char) ARCHIVE_VERSION;
+    encoded += (char) (options.blockOptions.checksummed ? ARCHIVE_FLAG_CHECKSUM : 0);
+    appendUint32(encoded, (uint32_t) options.blockOptions.blockSize);
+    output.write(encoded.data(), encoded.size());
+    uint64_t position = encoded.size();
+
+    Vector<ArchiveEntry> entries;
+    Vector<uint64_t> tableOffsets;
+    for (int first = 0; first < files.size(); first += ARCHIVE_BATCH_ENTRIES) {
+        int count = min(ARCHIVE_BATCH_ENTRIES, files.size() - first);
+        writeBatch(files, stored, first, count, options, output, position, entries, tableOffsets);
+    }
+
+    string directory;
+    uint64_t previous = 0;
+    for (int t = 0; t < tableOffsets.size(); t++) {
+        appendVarint(directory, tableOffsets[t] - previous);
+        previous = tableOffsets[t];
+    }
+    string previousName;
+    uint64_t previousEnd = ARCHIVE_HEADER_BYTES;
+    for (int i = 0; i < entries.size(); i++) {
+        const ArchiveEntry& entry = entries[i];
+        size_t shared = 0;
+        while (shared < previousName.size() && shared < entry.name.size() && previousName[shared] == entry.name[shared]) {
+            shared++;
+        }
+        appendVarint(directory, shared);
+        appendVarint(directory, entry.name.size() - shared);
+        directory.append(entry.name, shared, string::npos);
+        directory += (char) entry.method;
+        if (entry.method == ENTRY_SHARED) appendVarint(directory, entry.table);
+        appendVarint(directory, entry.size);
+        if (entry.method != ENTRY_STORED) appendVarint(directory, entry.payloadLength);
+        appendVarint(directory, entry.offset - previousEnd);
+        if (options.blockOptions.checksummed && entry.method != ENTRY_BLOCKS) {
+            appendUint32(directory, entry.checksum);
+        }
+        previousName = entry.name;
+        previousEnd = entry.offset + entry.payloadLength;
+    }
+    encoded.clear();
+    encodeBlocks((const unsigned char*) directory.data(), directory.size(), options.blockOptions, SIZE_MAX, encoded);
+    appendUint32(encoded, (uint32_t) tableOffsets.size());
+    appendUint32(encoded, (uint32_t) entries.size());
+    appendUint64(encoded, position);
+    appendUint64(encoded, directory.size());
+    encoded.append(DIRECTORY_MAGIC, 4);
+    output.write(encoded.data(), encoded.size());
+    output.flush();
+    if (!output) error("createArchive: could not write the output");
+}
+
+/*
+ * Adds every file under directory to files, with its path relative to the top directory in names.
+ */
+static void addDirectoryFiles(const string& directory, const string& prefix, Vector<string>& files,
+                              Vector<string>& names) {
+    Vector<string> children;
+    listDirectory(directory, children);
+    string separator = getDirectoryPathSeparator();
+    for (int i = 0; i < children.size(); i++) {
+        string path = directory + separator + children[i];
+        string name = prefix + children[i];
+        if (isDirectory(path)) {
+            addDirectoryFiles(path, name + "/", files, names);
+        } else if (isFile(path)) {
+            files.add(path);
+            names.add(name);
+        }
+    }
+}
+
+void createArchiveFromDirectory(const string& directory, ostream& output, const ArchiveOptions& options) {
+    if (!isDirectory(directory)) error("createArchiveFromDirectory: " + directory + " is not a directory");
+    Vector<string> files;
+    Vector<string> names;
+    addDirectoryFiles(directory, "", files, names);
+    createArchive(files, names, output, options);
+}
+
+ArchiveReader::ArchiveReader(string filename) {
+    if (!myFile.open(filename)) error("ArchiveReader: cannot open " + filename);
+    try {
+        readDirectory();
+    } catch (...) {
+        for (int t = 0; t < myTables.size(); t++) delete myTables[t];
+        throw;
+    }
+}
+
+ArchiveReader::~ArchiveReader() {
+    for (int t = 0; t < myTables.size(); t++) {
+        delete myTables[t];
+    }
+}
+
+/*
+ * Checks the header and trailer, decodes the directory, then reads the table offsets and entries
+ * from it and builds each shared table's decode table. Every offset and length is checked against
+ * the part of the archive it must lie in, so a damaged archive fails here rather than when it is
+ * extracted.
+ */
+void ArchiveReader::readDirectory() {
+    const unsigned char* data = myFile.data();
+    size_t size = myFile.size();
+    if (size < (size_t) (ARCHIVE_HEADER_BYTES + ARCHIVE_TRAILER_BYTES) || memcmp(data, ARCHIVE_MAGIC, 4) != 0
+            || memcmp(data + size - 4, DIRECTORY_MAGIC, 4) != 0) {
+        error("ArchiveReader: not an archive");
+    }
+    if (data[4] != ARCHIVE_VERSION || (data[5] & ~ARCHIVE_FLAG_CHECKSUM) != 0) {
+        error("ArchiveReader: unsupported archive version");
+    }
+    myChecksummed = (data[5] & ARCHIVE_FLAG_CHECKSUM) != 0;
+    myOptions.blockSize = (int) readUint32(data + 6);
+    if (myOptions.blockSize < 1 || myOptions.blockSize > MAX_BLOCK_SIZE) error("ArchiveReader: invalid block size");
+
+    const unsigned char* trailer = data + size - ARCHIVE_TRAILER_BYTES;
+    uint32_t numTables = readUint32(trailer);
+    uint32_t numEntries = readUint32(trailer + 4);
+    uint64_t directoryOffset = readUint64(trailer + 8);
+    uint64_t directorySize = readUint64(trailer + 16);
+    uint64_t directoryLength = size - ARCHIVE_TRAILER_BYTES - directoryOffset;
+    if (directoryOffset < (uint64_t) ARCHIVE_HEADER_BYTES || directoryOffset > size - ARCHIVE_TRAILER_BYTES
+            || directorySize / myOptions.blockSize > directoryLength / BLOCK_HEADER_BYTES) {
+        error("ArchiveReader: archive directory is corrupt");
+    }
+    string directory((size_t) directorySize, '\0');
+    decodeBlocks(data + directoryOffset, directoryLength, myOptions.blockSize, (unsigned char*) &directory[0],
+                 directorySize, "archive directory");
+
+    const unsigned char* p = (const unsigned char*) directory.data();
+    const unsigned char* end = p + directory.size();
+    uint64_t offset = 0;
+    for (uint32_t t = 0; t < numTables; t++) {
+        uint64_t delta;
+        if (!readVarint(p, end, delta) || delta > directoryOffset - offset) {
+            error("ArchiveReader: archive directory is corrupt");
+        }
+        offset += delta;
+        if (offset < (uint64_t) ARCHIVE_HEADER_BYTES || offset >= directoryOffset) {
+            error("ArchiveReader: archive directory is corrupt");
+        }
+        int lengths[256];
+        readCodeLengths(data + offset, directoryOffset - offset, lengths);
+        HuffmanCode code;
+        code.build(lengths, 256);
+        if (code.maxLength() > MAX_BLOCK_CODE_LENGTH) error("ArchiveReader: shared table is corrupt");
+        HuffmanDecodeTable* table = new HuffmanDecodeTable;
+        myTables.add(table);
+        table->build(code);
+    }
+
+    string name;
+    uint64_t previousEnd = ARCHIVE_HEADER_BYTES;
+    for (uint32_t i = 0; i < numEntries; i++) {
+        ArchiveEntry entry;
+        uint64_t shared, rest, table = 0, gap;
+        if (!readVarint(p, end, shared) || !readVarint(p, end, rest) || shared > name.size()
+                || rest >= (uint64_t) (end - p)) { //the method byte follows the name
+            error("ArchiveReader: archive directory is corrupt");
+        }
+        name.resize((size_t) shared);
+        name.append((const char*) p, (size_t) rest);
+        p += rest;
+        entry.name = name;
+        entry.method = *p++;
+        bool ok = entry.method <= ENTRY_SHARED;
+        if (entry.method == ENTRY_SHARED) ok = ok && readVarint(p, end, table) && table < numTables;
+        ok = ok && readVarint(p, end, entry.size);
+        entry.payloadLength = entry.size;
+        if (entry.method != ENTRY_STORED) ok = ok && readVarint(p, end, entry.payloadLength);
+        ok = ok && readVarint(p, end, gap) && gap <= directoryOffset - previousEnd
+                && entry.payloadLength <= directoryOffset - previousEnd - gap;
+        entry.checksum = 0;
+        if (ok && myChecksummed && entry.method != ENTRY_BLOCKS) {
+            ok = end - p >= 4;
+            if (ok) {
+                entry.checksum = readUint32(p);
+                p += 4;
+            }
+        }
+        if (!ok || archiveName(entry.name) != entry.name || myNames.containsKey(entry.name)
+                || (entry.method == ENTRY_SHARED && entry.size / 8 > entry.payloadLength) //codes are at least 1 bit
+                || (entry.method == ENTRY_BLOCKS
+                    && entry.size / myOptions.blockSize > entry.payloadLength / BLOCK_HEADER_BYTES)) {
+            error("ArchiveReader: archive directory is corrupt");
+        }
+        entry.table = (uint32_t) table;
+        entry.offset = previousEnd + gap;
+        previousEnd = entry.offset + entry.payloadLength;
+        myNames.put(entry.name, myEntries.size());
+        myEntries.add(entry);
+    }
+    if (p != end) error("ArchiveReader: archive directory is corrupt");
+}
+
+int ArchiveReader::size() const {
+    return myEntries.size();
+}
+
+const ArchiveEntry& ArchiveReader::entry(int index) const {
+    return myEntries[index];
+}
+
+int ArchiveReader::find(const string& name) const {
+    return myNames.containsKey(name) ? myNames.get(name) : -1;
+}
+
+/*
+ * Stored entries are copied, shared entries are decoded with their table in one call, and block
+ * entries are decoded like the directory.
+ * @index: the entry to decode
+ * @output: where its bytes go
+ */
+void ArchiveReader::extract(int index, string& output) const {
+    const ArchiveEntry& entry = myEntries[index];
+    if (entry.size > (uint64_t) output.max_size()) error("ArchiveReader: entry is too large to extract");
+    output.resize((size_t) entry.size);
+    const unsigned char* payload = myFile.data() + entry.offset;
+    unsigned char* out = (unsigned char*) &output[0];
+    if (entry.method == ENTRY_STORED) {
+        memcpy(out, payload, (size_t) entry.size);
+    } else if (entry.method == ENTRY_SHARED) {
+        decodeBitStream(*myTables[entry.table], payload, (size_t) entry.payloadLength, out, (size_t) entry.size);
+    } else {
+        decodeBlocks(payload, entry.payloadLength, myOptions.blockSize, out, entry.size, "entry " + entry.name);
+        return; //its blocks were checked as they were decoded
+    }
+    if (myChecksummed && crc32c(out, output.size()) != entry.checksum) {
+        error("ArchiveReader: entry " + entry.name + " is corrupt");
+    }
+}
+
+void ArchiveReader::extract(int index, ostream& output) const {
+    string bytes;
+    extract(index, bytes);
+    output.write(bytes.data(), bytes.size());
+}
+
+/*
+ * Creates the directories first, on one thread, so that the workers never race to create the
+ * same one, then extracts the entries in parallel.
+ */
+void ArchiveReader::extractAll(const string& directory, int numThreads) const {
+    string separator = getDirectoryPathSeparator();
+    Vector<string> paths;
+    string lastHead;
+    for (int i = 0; i < myEntries.size(); i++) {
+        string name = myEntries[i].name;
+        if (separator != "/") name = stringReplace(name, "/", separator);
+        string path = directory + separator + name;
+        string head = getHead(path);
+        if (head != lastHead) {
+            createDirectoryPath(head);
+            lastHead = head;
+        }
+        paths.add(path);
+    }
+    if (numThreads < 1) numThreads = max(1, (int) thread::hardware_concurrency());
+    runParallel(myEntries.size(), numThreads, [&](int i) {
+        string bytes;
+        extract(i, bytes);
+        ofstream file(paths[i].c_str(), ofstream::binary);
+        file.write(bytes.data(), bytes.size());
+        file.close();
+        if (!file) error("ArchiveReader: could not write " + paths[i]);
+    });
+}
@@ -0,0 +1,153 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the archive.h file which declares a multi-file archive built on the block format
+ * (blockcodec.h). Compressing files one by one makes each of them pay for its own header and code
+ * tables, which for small files is most of the output. An archive holds many files in one stream
+ * with a central directory at the end, and small files of the same kind (same extension) share one
+ * code table, so each of them costs only its coded bits and a directory entry.
+ *
+ * Archive layout (fixed-size integers little-endian, offsets from the start of the archive):
+ *   header:    "HARC", version byte, flags byte, block size (uint32)
+ *   data:      entry payloads and shared tables, in the order they were written
+ *   directory: blocks and an end marker, as in a block stream without its stream header
+ *   trailer:   number of tables (uint32), number of entries (uint32), directory offset (uint64),
+ *              decoded directory size (uint64), "HARD"
+ * An ENTRY_STORED payload is the file's bytes as they are; an ENTRY_BLOCKS payload is the file's
+ * blocks followed by an end marker, like the directory; an ENTRY_SHARED payload is one
+ * byte-aligned bit stream coded with the entry's shared table, which is stored as code lengths
+ * (as in a BLOCK_HUFFMAN payload).
+ * The decoded directory is made of variable-length integers (bytes.h). For each table it holds the
+ * table's offset minus the previous table's (or 0); then for each entry: the number of leading
+ * bytes its name shares with the previous entry's, the length of the rest of the name, the rest
+ * of the name, the method (one byte), the table number (ENTRY_SHARED only), the size, the
+ * payload length (not for ENTRY_STORED, where it is the size), the payload offset minus the
+ * end of the previous entry's payload (or of the header), and, if the header's flags have
+ * ARCHIVE_FLAG_CHECKSUM, the CRC-32C of the file (uint32) unless it is an ENTRY_BLOCKS entry,
+ * whose blocks carry their own. With sorted names and consecutive
+ * payloads, most of these are one byte, so a directory entry costs a few bytes per small file.
+ */
+
+#ifndef _archive_h
+#define _archive_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "MappedFile.h"
+#include "blockcodec.h"
+#include "huffmancode.h"
+#include "map.h"
+#include "vector.h"
+using namespace std;
+
+const int ARCHIVE_HEADER_BYTES = 10;
+const int ARCHIVE_TRAILER_BYTES = 28;
+const size_t DEFAULT_SHARED_MAX_BYTES = 1 << 16;   // files up to 64 KB may share a table
+const int ARCHIVE_BATCH_ENTRIES = 1024;            // files read and coded together
+const int ARCHIVE_FLAG_CHECKSUM = 1;               // every entry's data is checksummed
+
+enum EntryMethod {
+    ENTRY_STORED = 0,
+    ENTRY_BLOCKS = 1,
+    ENTRY_SHARED = 2
+};
+
+/*
+ * Settings for createArchive. The defaults are a good general choice.
+ */
+struct ArchiveOptions {
+    BlockOptions blockOptions;   // for files coded on their own (the index setting is ignored); with
+                                 // checksummed set, every entry is checksummed
+    size_t sharedMaxBytes;       // largest file that may use a shared table; 0 turns sharing off
+    int numThreads;              // threads reading and coding files
+    ArchiveOptions();
+};
+
+/*
+ * One file in an archive's directory.
+ */
+struct ArchiveEntry {
+    string name;              // path inside the archive, '/'-separated and relative
+    int method;               // one of the EntryMethod values
+    uint32_t table;           // ENTRY_SHARED: the shared table it is coded with
+    uint64_t size;            // bytes the file decodes to
+    uint64_t offset;          // where its payload starts
+    uint64_t payloadLength;   // bytes of payload
+    uint32_t checksum;        // CRC-32C of the file, if the archive is checksummed and the entry
+                              // is not ENTRY_BLOCKS
+};
+
+/*
+ * Writes an archive of the given files. Files are read and coded ARCHIVE_BATCH_ENTRIES at a
+ * time on options.numThreads threads, and each batch's files are grouped by extension to build
+ * the shared tables, so memory use is bounded by one batch however many files there are.
+ * Throws an error if a file can't be read or a name can't be stored, or if two names are the same
+ * once stored (such as "a.txt" and "./a.txt"); nothing is written in that case.
+ * @files: the files to add
+ * @names: the name each file gets in the archive (relative, '/' or the platform separator)
+ */
+void createArchive(const Vector<string>& files, const Vector<string>& names, ostream& output,
+                   const ArchiveOptions& options = ArchiveOptions());
+
+/*
+ * Writes an archive of every file under directory, named by their paths relative to it.
+ */
+void createArchiveFromDirectory(const string& directory, ostream& output,
+                                const ArchiveOptions& options = ArchiveOptions());
+
+/*
+ * Read access to an archive file. The archive is mapped into memory and its directory and shared
+ * tables are loaded once when it is opened; after that every method is const and may be called
+ * from several threads at once.
+ */
+class ArchiveReader {
+public:
+    /*
+     * Opens the archive. Throws an error if it can't be read or is not a valid archive.
+     */
+    ArchiveReader(string filename);
+
+    ~ArchiveReader();
+
+    /*
+     * Returns the number of entries and the given entry.
+     */
+    int size() const;
+    const ArchiveEntry& entry(int index) const;
+
+    /*
+     * Returns the index of the entry with the given name, or -1 if there is none.
+     */
+    int find(const string& name) const;
+
+    /*
+     * Decodes one entry into output (replacing its contents) or onto a stream.
+     * Throws an error if the entry's data is damaged (which is always noticed in a checksummed
+     * archive).
+     */
+    void extract(int index, string& output) const;
+    void extract(int index, ostream& output) const;
+
+    /*
+     * Extracts every entry to a file under directory, creating subdirectories as needed, on
+     * numThreads threads (0 for one per core). Existing files are overwritten.
+     * Throws an error (after the other entries are done) if any entry could not be extracted.
+     */
+    void extractAll(const string& directory, int numThreads = 0) const;
+
+private:
+    ArchiveReader(const ArchiveReader& other);            // not copyable (owns the mapping and tables)
+    ArchiveReader& operator =(const ArchiveReader& other);
+
+    void readDirectory(); //loads the entries and shared tables, checking every offset
+
+    MappedFile myFile;
+    BlockOptions myOptions; //the archive's block size
+    bool myChecksummed; //entries have checksums
+    Vector<ArchiveEntry> myEntries;
+    Map<string, int> myNames; //entry index by name
+    Vector<HuffmanDecodeTable*> myTables; //shared tables by number
+};
+
+#endif
@@ -0,0 +1,1053 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the block-based compressed format described in blockcodec.h.
+ * Encoding a block is: histogram (countBytes), code lengths limited to maxCodeLength (HuffmanPool),
+ * canonical codes (HuffmanCode), then the bits through a BitWriter. Decoding uses one
+ * HuffmanDecodeTable lookup per character, and since the code lengths are limited, a single
+ * refill of a BitReader's 64-bit window is enough for several characters in a row. For four-stream
+ * blocks the decode loop advances all four readers together, so the CPU can work on four
+ * independent dependency chains instead of waiting on one. Order-1 blocks group the 256
+ * previous-character contexts into a few clusters that each get a code; the decode loops take the
+ * table to use from an array indexed by the previous character, so order 0 and order 1 share them.
+ */
+
+#include "blockcodec.h"
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "bytes.h"
+#include "checksum.h"
+#include "error.h"
+#include "histogram.h"
+#include "huffmancode.h"
+#include "strlib.h"
+#include "tans.h"
+
+static const char STREAM_MAGIC[] = "HUFB";
+static const int STREAM_VERSION = 1;
+static const int NUM_STREAMS = 4;
+static const int JUMP_TABLE_BYTES = 4 * (NUM_STREAMS - 1);
+static const char INDEX_MAGIC[] = "HFBI";
+static const int CONTEXT_MAP_BYTES = 128;
+static const int CLUSTER_ROUNDS = 4;         //rounds of moving contexts to their cheapest cluster
+static const int MAX_CODE_LENGTH_BITS = 8 * 129; //most that writeCodeLengths can take
+
+BlockOptions::BlockOptions() {
+    blockSize = DEFAULT_BLOCK_SIZE;
+    maxCodeLength = DEFAULT_BLOCK_CODE_LENGTH;
+    interleaved = true;
+    indexed = true;
+    checksummed = true;
+    backend = BACKEND_HUFFMAN;
+}
+
+static void checkOptions(const BlockOptions& options) {
+    if (options.blockSize < 1 || options.blockSize > MAX_BLOCK_SIZE) {
+        error("BlockOptions: block size must be between 1 and " + integerToString(MAX_BLOCK_SIZE));
+    }
+    if (options.maxCodeLength < 8 || options.maxCodeLength > MAX_BLOCK_CODE_LENGTH) { //8 bits are needed for 256 characters
+        error("BlockOptions: max code length must be between 8 and " + integerToString(MAX_BLOCK_CODE_LENGTH));
+    }
+}
+
+void writeStreamHeader(string& output, const BlockOptions& options) {
+    checkOptions(options);
+    output.append(STREAM_MAGIC, 4);
+    output += (char) STREAM_VERSION;
+    output += (char) ((options.indexed ? STREAM_FLAG_INDEX : 0) | (options.checksummed ? STREAM_FLAG_CHECKSUM : 0));
+    appendUint32(output, (uint32_t) options.blockSize);
+}
+
+void readStreamHeader(istream& input, BlockOptions& options) {
+    unsigned char header[STREAM_HEADER_BYTES];
+    input.read((char*) header, STREAM_HEADER_BYTES);
+    if (input.gcount() != STREAM_HEADER_BYTES) {
+        error("readStreamHeader: not a block-compressed stream");
+    }
+    parseStreamHeader(header, options);
+}
+
+void parseStreamHeader(const unsigned char* bytes, BlockOptions& options) {
+    if (memcmp(bytes, STREAM_MAGIC, 4) != 0) {
+        error("parseStreamHeader: not a block-compressed stream");
+    }
+    if (bytes[4] != STREAM_VERSION) {
+        error("parseStreamHeader: unsupported block format version");
+    }
+    if ((bytes[5] & ~(STREAM_FLAG_INDEX | STREAM_FLAG_CHECKSUM)) != 0) {
+        error("parseStreamHeader: unsupported block format flags");
+    }
+    options.indexed = (bytes[5] & STREAM_FLAG_INDEX) != 0;
+    options.checksummed = (bytes[5] & STREAM_FLAG_CHECKSUM) != 0;
+    options.blockSize = (int) readUint32(bytes + 6);
+    if (options.blockSize < 1 || options.blockSize > MAX_BLOCK_SIZE) {
+        error("parseStreamHeader: invalid block size");
+    }
+}
+
+void parseBlockHeader(const unsigned char* bytes, BlockHeader& header) {
+    header.type = bytes[0];
+    header.rawLength = readUint32(bytes + 1);
+    header.payloadLength = readUint32(bytes + 5);
+}
+
+/*
+ * Reads the next block header, returning false for the end marker.
+ */
+bool readBlockHeader(istream& input, BlockHeader& header) {
+    unsigned char bytes[BLOCK_HEADER_BYTES];
+    input.read((char*) bytes, BLOCK_HEADER_BYTES);
+    if (input.gcount() != BLOCK_HEADER_BYTES) {
+        error("readBlockHeader: compressed stream is truncated");
+    }
+    parseBlockHeader(bytes, header);
+    return header.type != BLOCK_END;
+}
+
+void appendEndBlock(string& output) {
+    output.append(BLOCK_HEADER_BYTES, '\0');
+}
+
+/*
+ * Fills in a block header that was reserved at position start of output, once the payload after it is done.
+ */
+static void finishBlockHeader(string& output, size_t start, int type, size_t rawLength) {
+    unsigned char* p = (unsigned char*) &output[start];
+    p[0] = (unsigned char) type;
+    storeUint32(p + 1, (uint32_t) rawLength);
+    storeUint32(p + 5, (uint32_t) (output.size() - start - BLOCK_HEADER_BYTES));
+}
+
+/*
+ * Stores code lengths for characters 0 .. (last one with a code), two per byte.
+ */
+void writeCodeLengths(string& output, const int lengths[256]) {
+    int count = 256;
+    while (count > 1 && lengths[count - 1] == 0) count--;
+    output += (char) (count - 1);
+    for (int ch = 0; ch < count; ch += 2) {
+        int high = ch + 1 < count ? lengths[ch + 1] : 0;
+        output += (char) (lengths[ch] | (high << 4));
+    }
+}
+
+/*
+ * Reads the code lengths written by writeCodeLengths, returning the number of payload bytes they took.
+ */
+size_t readCodeLengths(const unsigned char* p, size_t available, int lengths[256]) {
+    if (available < 1) error("decodeBlock: block is truncated");
+    int count = p[0] + 1;
+    size_t bytes = 1 + (count + 1) / 2;
+    if (available < bytes) error("decodeBlock: block is truncated");
+    for (int ch = 0; ch < 256; ch++) {
+        lengths[ch] = 0;
+    }
+    for (int ch = 0; ch < count; ch++) {
+        lengths[ch] = (p[1 + ch / 2] >> (4 * (ch & 1))) & 0x0f;
+    }
+    return bytes;
+}
+
+/*
+ * The codes a block is written with: each character is coded with code contextMap[previous
+ * character]. An order-0 block has a single code and a map of all zeros.
+ */
+struct BlockCodes {
+    int numTables;
+    unsigned char contextMap[256];
+    int lengths[MAX_CONTEXT_TABLES][256];
+    uint32_t bits[MAX_CONTEXT_TABLES][256];   // filled in by assignCodes
+};
+
+/*
+ * Sets up an order-0 BlockCodes with the given code lengths.
+ */
+static void singleCode(const int lengths[256], BlockCodes& codes) {
+    codes.numTables = 1;
+    memset(codes.contextMap, 0, sizeof(codes.contextMap));
+    memcpy(codes.lengths[0], lengths, sizeof(codes.lengths[0]));
+}
+
+/*
+ * Fills in the canonical code bits for every table's lengths.
+ */
+static void assignCodes(BlockCodes& codes) {
+    for (int t = 0; t < codes.numTables; t++) {
+        HuffmanCode code;
+        code.build(codes.lengths[t], 256);
+        for (int ch = 0; ch < 256; ch++) {
+            codes.bits[t][ch] = code.bits(ch);
+        }
+    }
+}
+
+/*
+ * Writes the codes of length characters as one byte-aligned bit stream appended to output.
+ * The stream starts out in context 0.
+ */
+static void encodeSymbols(const unsigned char* data, size_t length, const BlockCodes& codes, string& output) {
+    BitWriter writer(output);
+    unsigned char previous = 0;
+    for (size_t i = 0; i < length; i++) {
+        int t = codes.contextMap[previous];
+        writer.writeBits(codes.bits[t][data[i]], codes.lengths[t][data[i]]);
+        previous = data[i];
+    }
+    writer.flush();
+}
+
+/*
+ * Writes the block's characters as one stream, or as four streams behind a jump table of the
+ * first three streams' sizes.
+ */
+static void encodeStreams(const unsigned char* data, size_t length, const BlockCodes& codes, bool interleaved,
+                          string& output) {
+    if (!interleaved) {
+        encodeSymbols(data, length, codes, output);
+        return;
+    }
+    size_t jumpTable = output.size();
+    output.append(JUMP_TABLE_BYTES, '\0');
+    size_t segment = (length + NUM_STREAMS - 1) / NUM_STREAMS;
+    for (int s = 0; s < NUM_STREAMS; s++) {
+        size_t begin = s * segment;
+        size_t end = min(length, begin + segment);
+        size_t before = output.size();
+        encodeSymbols(data + begin, end - begin, codes, output);
+        if (s < NUM_STREAMS - 1) {
+            storeUint32((unsigned char*) &output[jumpTable + 4 * s], (uint32_t) (output.size() - before));
+        }
+    }
+}
+
+/*
+ * Returns the Shannon entropy of a histogram in bytes. No prefix code can encode the block in
+ * less, so when this is already too big the code doesn't need to be built at all.
+ */
+static double entropyBytes(const uint64_t counts[256], size_t length) {
+    double bits = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        if (counts[ch] > 0) bits += counts[ch] * log2((double) length / counts[ch]);
+    }
+    return bits / 8;
+}
+
+/*
+ * Returns the number of bytes writeCodeLengths takes for the given lengths.
+ */
+static size_t codeLengthBytes(const int lengths[256]) {
+    int count = 1;
+    for (int ch = 0; ch < 256; ch++) {
+        if (lengths[ch] > 0) count = ch + 1;
+    }
+    return 1 + (count + 1) / 2;
+}
+
+/*
+ * Returns the payload size a block would have when coded with the given code lengths.
+ */
+static size_t codedBytes(const uint64_t counts[256], const int lengths[256], bool interleaved) {
+    uint64_t bits = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        bits += counts[ch] * lengths[ch];
+    }
+    return codeLengthBytes(lengths) + (size_t) (bits / 8) + (interleaved ? JUMP_TABLE_BYTES + NUM_STREAMS : 1);
+}
+
+/*
+ * Estimates each character's code length in bits from a cluster's counts. Characters the cluster
+ * has not seen get a long but finite length, so that a context can still move to it.
+ */
+static void estimateBits(const uint64_t counts[256], double bits[256]) {
+    uint64_t total = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        total += counts[ch];
+    }
+    double scale = log2(total + 1.0);
+    for (int ch = 0; ch < 256; ch++) {
+        bits[ch] = scale - log2(counts[ch] + 1.0 / 256);
+    }
+}
+
+/*
+ * Returns an estimate of the bits a cluster with these counts costs: its entropy plus its stored
+ * code lengths.
+ */
+static double clusterBits(const uint64_t counts[256]) {
+    uint64_t total = 0;
+    int count = 1;
+    for (int ch = 0; ch < 256; ch++) {
+        total += counts[ch];
+        if (counts[ch] > 0) count = ch + 1;
+    }
+    double bits = 8.0 * (1 + (count + 1) / 2);
+    for (int ch = 0; ch < 256; ch++) {
+        if (counts[ch] > 0) bits += counts[ch] * log2((double) total / counts[ch]);
+    }
+    return bits;
+}
+
+/*
+ * The contexts that occur in a block, with each one's counts stored sparsely (most contexts are
+ * followed by only a few different characters).
+ */
+struct ContextStats {
+    int numContexts;
+    unsigned char contexts[256];                // the previous characters that occur
+    int numFollowers[256];                      // by context: how many different characters follow it
+    unsigned char followers[256][256];          // by context: those characters
+    uint32_t counts[256][256];                  // counts[previous][ch]
+};
+
+/*
+ * Returns the estimated bits of coding a context's characters with the given code lengths.
+ */
+static double contextBits(const ContextStats& stats, int context, const double bits[256]) {
+    double total = 0;
+    for (int i = 0; i < stats.numFollowers[context]; i++) {
+        int ch = stats.followers[context][i];
+        total += stats.counts[context][ch] * bits[ch];
+    }
+    return total;
+}
+
+/*
+ * Groups the contexts into at most MAX_CONTEXT_TABLES clusters, k-means style. The first seed is
+ * the most common context and each further seed is the context its nearest seed codes worst
+ * compared to its own statistics. Then for a few rounds every context moves to the cluster that
+ * codes it in the fewest bits, and finally clusters are merged in pairs for as long as the saving
+ * in stored code lengths outweighs the bits lost by sharing a code.
+ * @stats: the block's context statistics
+ * @contextMap: set to each context's cluster (0 for contexts that don't occur)
+ * @clusterCounts: set to the character counts of each cluster
+ * Returns the number of clusters.
+ */
+static int clusterContexts(const ContextStats& stats, unsigned char contextMap[256],
+                           uint64_t clusterCounts[MAX_CONTEXT_TABLES][256]) {
+    memset(contextMap, 0, 256);
+    double ownBits[256];      //by context: bits with its own code
+    double nearestBits[256];  //by context: bits with the best seed so far
+    uint64_t contextTotals[256];
+    int first = stats.contexts[0];
+    for (int i = 0; i < stats.numContexts; i++) {
+        int context = stats.contexts[i];
+        uint64_t counts[256] = {0};
+        contextTotals[context] = 0;
+        for (int k = 0; k < stats.numFollowers[context]; k++) {
+            int ch = stats.followers[context][k];
+            counts[ch] = stats.counts[context][ch];
+            contextTotals[context] += counts[ch];
+        }
+        double bits[256];
+        estimateBits(counts, bits);
+        ownBits[context] = contextBits(stats, context, bits);
+        nearestBits[context] = 1e300;
+        if (contextTotals[context] > contextTotals[first]) first = context;
+    }
+
+    double bits[MAX_CONTEXT_TABLES][256];
+    int numClusters = 0;
+    int seed = first;
+    while (true) {
+        uint64_t counts[256] = {0};
+        for (int k = 0; k < stats.numFollowers[seed]; k++) {
+            int ch = stats.followers[seed][k];
+            counts[ch] = stats.counts[seed][ch];
+        }
+        estimateBits(counts, bits[numClusters++]);
+        if (numClusters == MAX_CONTEXT_TABLES || numClusters == stats.numContexts) break;
+        double worst = 0;
+        for (int i = 0; i < stats.numContexts; i++) {
+            int context = stats.contexts[i];
+            nearestBits[context] = min(nearestBits[context], contextBits(stats, context, bits[numClusters - 1]));
+            if (nearestBits[context] - ownBits[context] > worst) {
+                worst = nearestBits[context] - ownBits[context];
+                seed = context;
+            }
+        }
+        if (worst < MAX_CODE_LENGTH_BITS) break; //no context is coded badly enough to need a code of its own
+    }
+
+    for (int round = 0; round < CLUSTER_ROUNDS; round++) {
+        for (int i = 0; i < stats.numContexts; i++) {
+            int context = stats.contexts[i];
+            double best = 0;
+            for (int c = 0; c < numClusters; c++) {
+                double cost = contextBits(stats, context, bits[c]);
+                if (c == 0 || cost < best) {
+                    best = cost;
+                    contextMap[context] = (unsigned char) c;
+                }
+            }
+        }
+        //recount, dropping clusters that lost all their contexts
+        int renumber[MAX_CONTEXT_TABLES];
+        int used = 0;
+        for (int c = 0; c < numClusters; c++) {
+            renumber[c] = -1;
+        }
+        for (int i = 0; i < stats.numContexts; i++) {
+            int c = contextMap[stats.contexts[i]];
+            if (renumber[c] < 0) renumber[c] = used++;
+        }
+        memset(clusterCounts, 0, sizeof(uint64_t) * MAX_CONTEXT_TABLES * 256);
+        for (int i = 0; i < stats.numContexts; i++) {
+            int context = stats.contexts[i];
+            int c = renumber[contextMap[context]];
+            contextMap[context] = (unsigned char) c;
+            for (int k = 0; k < stats.numFollowers[context]; k++) {
+                int ch = stats.followers[context][k];
+                clusterCounts[c][ch] += stats.counts[context][ch];
+            }
+        }
+        numClusters = used;
+        for (int c = 0; c < numClusters; c++) {
+            estimateBits(clusterCounts[c], bits[c]);
+        }
+    }
+
+    //merge the pair that saves the most bits until no merge saves any
+    double cost[MAX_CONTEXT_TABLES];
+    double saving[MAX_CONTEXT_TABLES][MAX_CONTEXT_TABLES];
+    for (int a = 0; a < numClusters; a++) {
+        cost[a] = clusterBits(clusterCounts[a]);
+    }
+    for (int a = 0; a < numClusters; a++) {
+        for (int b = a + 1; b < numClusters; b++) {
+            uint64_t merged[256];
+            for (int ch = 0; ch < 256; ch++) {
+                merged[ch] = clusterCounts[a][ch] + clusterCounts[b][ch];
+            }
+            saving[a][b] = cost[a] + cost[b] - clusterBits(merged);
+        }
+    }
+    while (numClusters > 1) {
+        int bestA = 0;
+        int bestB = 1;
+        for (int a = 0; a < numClusters; a++) {
+            for (int b = a + 1; b < numClusters; b++) {
+                if (saving[a][b] > saving[bestA][bestB]) {
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        if (saving[bestA][bestB] <= 0) break;
+        //merge bestB into bestA, then move the last cluster into bestB's place
+        int last = numClusters - 1;
+        for (int ch = 0; ch < 256; ch++) {
+            clusterCounts[bestA][ch] += clusterCounts[bestB][ch];
+            clusterCounts[bestB][ch] = clusterCounts[last][ch];
+        }
+        cost[bestA] = clusterBits(clusterCounts[bestA]);
+        cost[bestB] = cost[last];
+        for (int i = 0; i < stats.numContexts; i++) {
+            unsigned char& c = contextMap[stats.contexts[i]];
+            if (c == bestB) {
+                c = (unsigned char) bestA;
+            } else if (c == last) {
+                c = (unsigned char) bestB;
+            }
+        }
+        for (int c = 0; c < last; c++) { //pairs with the cluster now at bestB keep their savings
+            if (c != bestB) saving[min(c, bestB)][max(c, bestB)] = saving[min(c, last)][max(c, last)];
+        }
+        numClusters--;
+        for (int c = 0; c < numClusters; c++) {
+            if (c == bestA) continue;
+            uint64_t merged[256];
+            for (int ch = 0; ch < 256; ch++) {
+                merged[ch] = clusterCounts[bestA][ch] + clusterCounts[c][ch];
+            }
+            saving[min(c, bestA)][max(c, bestA)] = cost[bestA] + cost[c] - clusterBits(merged);
+        }
+    }
+    return numClusters;
+}
+
+/*
+ * Builds an order-1 code for a block: counts which character follows which (each stream starting
+ * in context 0, as the decoder does), clusters the contexts and builds a length-limited code for
+ * each cluster.
+ * @codes: where the codes go
+ * Returns the payload size the block would have with these codes.
+ */
+static size_t buildContextCodes(const unsigned char* data, size_t length, bool interleaved, int maxCodeLength,
+                                BlockCodes& codes) {
+    unique_ptr<ContextStats> stats(new ContextStats); //too big for the stack
+    memset(stats->counts, 0, sizeof(stats->counts));
+    if (interleaved) {
+        size_t segment = (length + NUM_STREAMS - 1) / NUM_STREAMS;
+        for (int s = 0; s < NUM_STREAMS; s++) {
+            size_t begin = s * segment;
+            countPairs(data + begin, min(length, begin + segment) - begin, stats->counts);
+        }
+    } else {
+        countPairs(data, length, stats->counts);
+    }
+    stats->numContexts = 0;
+    for (int context = 0; context < 256; context++) {
+        stats->numFollowers[context] = 0;
+        for (int ch = 0; ch < 256; ch++) {
+            if (stats->counts[context][ch] > 0) stats->followers[context][stats->numFollowers[context]++] = (unsigned char) ch;
+        }
+        if (stats->numFollowers[context] > 0) stats->contexts[stats->numContexts++] = (unsigned char) context;
+    }
+
+    uint64_t clusterCounts[MAX_CONTEXT_TABLES][256];
+    codes.numTables = clusterContexts(*stats, codes.contextMap, clusterCounts);
+    size_t bytes = 1 + CONTEXT_MAP_BYTES + (interleaved ? JUMP_TABLE_BYTES + NUM_STREAMS : 1);
+    uint64_t bits = 0;
+    HuffmanPool pool;
+    for (int t = 0; t < codes.numTables; t++) {
+        pool.build(clusterCounts[t], 256);
+        pool.codeLengths(codes.lengths[t], 256, maxCodeLength);
+        bytes += codeLengthBytes(codes.lengths[t]);
+        for (int ch = 0; ch < 256; ch++) {
+            bits += clusterCounts[t][ch] * codes.lengths[t][ch];
+        }
+    }
+    return bytes + (size_t) (bits / 8);
+}
+
+/*
+ * Stores an order-1 block's codes: their number, the context map and each code's lengths.
+ */
+static void writeContextCodes(string& output, const BlockCodes& codes) {
+    output += (char) (codes.numTables - 1);
+    for (int context = 0; context < 256; context += 2) {
+        output += (char) (codes.contextMap[context] | (codes.contextMap[context + 1] << 4));
+    }
+    for (int t = 0; t < codes.numTables; t++) {
+        writeCodeLengths(output, codes.lengths[t]);
+    }
+}
+
+/*
+ * Stores a block as it is, for data that coding would not shrink.
+ */
+static void encodeRawBlock(const unsigned char* data, size_t length, string& output) {
+    size_t start = output.size();
+    output.append(BLOCK_HEADER_BYTES, '\0');
+    output.append((const char*) data, length);
+    finishBlockHeader(output, start, BLOCK_RAW, length);
+}
+
+/*
+ * Encodes one block. The code lengths come from the block's own histogram; blocks of
+ * INTERLEAVE_MIN_BYTES or more are split into four streams when the options ask for it.
+ * A block of one repeated byte becomes a BLOCK_RUN, and a block that coding would not shrink
+ * by at least 1/RAW_SAVINGS_DIVISOR is stored raw: first by checking the entropy of the
+ * histogram (cheap, and catches random and compressed data before any code is built), then by
+ * the exact coded size once the code lengths are known. With the tANS backend the block is
+ * coded with encodeTans instead, subject to the same size check. With the order-1 backend the
+ * block also gets a set of context codes, which are used if they come out smaller than one code.
+ * @data: the block's bytes
+ * @length: the number of bytes (at most the block size, and more than 0)
+ * @options: the compression settings
+ * @output: where the block (header and payload) is appended
+ */
+static void encodeUncheckedBlock(const unsigned char* data, size_t length, const BlockOptions& options,
+                                 string& output) {
+    uint64_t counts[256] = {0};
+    countBytes(data, length, counts);
+    if (counts[data[0]] == length) {
+        size_t start = output.size();
+        output.append(BLOCK_HEADER_BYTES, '\0');
+        output += (char) data[0];
+        finishBlockHeader(output, start, BLOCK_RUN, length);
+        return;
+    }
+    size_t worthCoding = length - length / RAW_SAVINGS_DIVISOR;
+    if (entropyBytes(counts, length) >= worthCoding) {
+        encodeRawBlock(data, length, output);
+        return;
+    }
+    if (options.backend == BACKEND_TANS) {
+        size_t start = output.size();
+        output.append(BLOCK_HEADER_BYTES, '\0');
+        encodeTans(data, length, counts, output);
+        if (output.size() - start - BLOCK_HEADER_BYTES >= worthCoding) {
+            output.resize(start);
+            encodeRawBlock(data, length, output);
+        } else {
+            finishBlockHeader(output, start, BLOCK_TANS, length);
+        }
+        return;
+    }
+    HuffmanPool pool;
+    pool.build(counts, 256);
+    int lengths[256];
+    pool.codeLengths(lengths, 256, options.maxCodeLength);
+    bool interleaved = options.interleaved && length >= (size_t) INTERLEAVE_MIN_BYTES;
+    size_t bytes = codedBytes(counts, lengths, interleaved);
+    unique_ptr<BlockCodes> codes(new BlockCodes);
+    bool contextCoded = false;
+    if (options.backend == BACKEND_ORDER1) {
+        size_t contextBytes = buildContextCodes(data, length, interleaved, options.maxCodeLength, *codes);
+        contextCoded = codes->numTables > 1 && contextBytes < bytes;
+        if (contextCoded) bytes = contextBytes;
+    }
+    if (bytes >= worthCoding) {
+        encodeRawBlock(data, length, output);
+        return;
+    }
+    if (!contextCoded) singleCode(lengths, *codes);
+    assignCodes(*codes);
+
+    size_t start = output.size();
+    output.append(BLOCK_HEADER_BYTES, '\0');
+    int type;
+    if (contextCoded) {
+        writeContextCodes(output, *codes);
+        type = interleaved ? BLOCK_ORDER1_X4 : BLOCK_ORDER1;
+    } else {
+        writeCodeLengths(output, lengths);
+        type = interleaved ? BLOCK_HUFFMAN_X4 : BLOCK_HUFFMAN;
+    }
+    encodeStreams(data, length, *codes, interleaved, output);
+    finishBlockHeader(output, start, type, length);
+}
+
+/*
+ * Encodes the block, then appends the checksum if the options ask for one. The checksum covers
+ * the payload rather than the decoded bytes: that is what a damaged file damages, it is usually
+ * much shorter, and it can be checked before the decoder ever sees it.
+ */
+void encodeBlock(const unsigned char* data, size_t length, const BlockOptions& options, string& output) {
+    size_t start = output.size();
+    encodeUncheckedBlock(data, length, options, output);
+    if (options.checksummed) {
+        size_t payloadStart = start + BLOCK_HEADER_BYTES;
+        appendUint32(output, crc32c((const unsigned char*) output.data() + payloadStart, output.size() - payloadStart));
+        finishBlockHeader(output, start, (unsigned char) output[start] | BLOCK_FLAG_CHECKSUM, length);
+    }
+}
+
+/*
+ * Decodes one character with a single table lookup. The caller refills the reader; an invalid
+ * code is recorded in bad rather than branched on, to keep the loop tight.
+ */
+static inline unsigned char decodeOne(BitReader& reader, const HuffmanDecodeTable& table, uint32_t& bad) {
+    uint32_t entry = table.entry(reader.window());
+    int length = HuffmanDecodeTable::entryLength(entry);
+    bad |= (length == 0);
+    reader.consume(length);
+    return (unsigned char) HuffmanDecodeTable::entrySymbol(entry);
+}
+
+/*
+ * The decode loops ask one of these for the table of each character. An order-0 block has one
+ * table whatever came before; an order-1 block indexes its tables by the previous character, so
+ * switching tables is an array lookup rather than a branch. With SingleTable the previous
+ * character goes unused and the loops compile down to plain order-0 decoding.
+ */
+struct SingleTable {
+    const HuffmanDecodeTable* table;
+
+    int tableBits() const {
+        return table->tableBits();
+    }
+
+    const HuffmanDecodeTable& operator ()(unsigned char) const {
+        return *table;
+    }
+};
+
+struct ContextTables {
+    const HuffmanDecodeTable* tables[256];   // by previous character
+    int maxTableBits;
+
+    int tableBits() const {
+        return maxTableBits;
+    }
+
+    const HuffmanDecodeTable& operator ()(unsigned char previous) const {
+        return *tables[previous];
+    }
+};
+
+/*
+ * Decodes count characters from one bit stream, several per refill.
+ */
+template <typename Tables>
+static void decodeSymbols(const Tables& tables, const unsigned char* bits, size_t numBytes,
+                          unsigned char* output, size_t count) {
+    BitReader reader(bits, numBytes);
+    size_t perRefill = 56 / tables.tableBits();
+    uint32_t bad = 0;
+    unsigned char previous = 0;
+    size_t i = 0;
+    while (i + perRefill <= count) {
+        reader.refill();
+        for (size_t k = 0; k < perRefill; k++) {
+            previous = output[i++] = decodeOne(reader, tables(previous), bad);
+        }
+    }
+    while (i < count) {
+        reader.refill();
+        previous = output[i++] = decodeOne(reader, tables(previous), bad);
+    }
+    if (bad || reader.bitsAvailable() < 0) error("decodeBlock: block data is corrupt");
+}
+
+/*
+ * The single-table case of decodeSymbols, for codes kept outside of any block.
+ */
+void decodeBitStream(const HuffmanDecodeTable& table, const unsigned char* bits, size_t numBytes,
+                     unsigned char* output, size_t count) {
+    SingleTable singleTable = {&table};
+    decodeSymbols(singleTable, bits, numBytes, output, count);
+}
+
+/*
+ * Decodes a four-stream block. The main loop refills all four readers and then decodes a run of
+ * characters from each in turn; the four streams don't depend on each other, so their lookups
+ * overlap. The last quarter is the shortest, so the loop runs until it is nearly done and each
+ * stream's leftovers are finished one at a time.
+ */
+template <typename Tables>
+static void decodeSymbolsX4(const Tables& tables, const unsigned char* streams[NUM_STREAMS],
+                            const size_t sizes[NUM_STREAMS], unsigned char* output, size_t length) {
+    size_t segment = (length + NUM_STREAMS - 1) / NUM_STREAMS;
+    size_t lastCount = length - (NUM_STREAMS - 1) * segment;
+    BitReader r0(streams[0], sizes[0]);
+    BitReader r1(streams[1], sizes[1]);
+    BitReader r2(streams[2], sizes[2]);
+    BitReader r3(streams[3], sizes[3]);
+    unsigned char* o0 = output;
+    unsigned char* o1 = output + segment;
+    unsigned char* o2 = output + 2 * segment;
+    unsigned char* o3 = output + 3 * segment;
+    unsigned char previous[NUM_STREAMS] = {0, 0, 0, 0};
+    size_t perRefill = 56 / tables.tableBits();
+    uint32_t bad = 0;
+    size_t done = 0;
+    while (done + perRefill <= lastCount) {
+        r0.refill();
+        r1.refill();
+        r2.refill();
+        r3.refill();
+        for (size_t k = 0; k < perRefill; k++) {
+            previous[0] = o0[done + k] = decodeOne(r0, tables(previous[0]), bad);
+            previous[1] = o1[done + k] = decodeOne(r1, tables(previous[1]), bad);
+            previous[2] = o2[done + k] = decodeOne(r2, tables(previous[2]), bad);
+            previous[3] = o3[done + k] = decodeOne(r3, tables(previous[3]), bad);
+        }
+        done += perRefill;
+    }
+
+    BitReader* readers[NUM_STREAMS] = {&r0, &r1, &r2, &r3};
+    unsigned char* outputs[NUM_STREAMS] = {o0, o1, o2, o3};
+    for (int s = 0; s < NUM_STREAMS; s++) {
+        size_t count = s < NUM_STREAMS - 1 ? segment : lastCount;
+        for (size_t i = done; i < count; i++) {
+            readers[s]->refill();
+            previous[s] = outputs[s][i] = decodeOne(*readers[s], tables(previous[s]), bad);
+        }
+        if (readers[s]->bitsAvailable() < 0) bad = 1;
+    }
+    if (bad) error("decodeBlock: block data is corrupt");
+}
+
+/*
+ * Decodes the coded characters of a block, which are either one stream or a jump table and four
+ * streams.
+ * @p: the payload after the code lengths
+ * @remaining: the number of bytes left in the payload
+ */
+template <typename Tables>
+static void decodeStreams(const Tables& tables, const unsigned char* p, size_t remaining, bool interleaved,
+                          unsigned char* output, size_t length) {
+    if (!interleaved) {
+        decodeSymbols(tables, p, remaining, output, length);
+        return;
+    }
+    if (length < (size_t) INTERLEAVE_MIN_BYTES || remaining < (size_t) JUMP_TABLE_BYTES) {
+        error("decodeBlock: block data is corrupt");
+    }
+    const unsigned char* streams[NUM_STREAMS];
+    size_t sizes[NUM_STREAMS];
+    size_t offset = JUMP_TABLE_BYTES;
+    for (int s = 0; s < NUM_STREAMS; s++) {
+        sizes[s] = s < NUM_STREAMS - 1 ? readUint32(p + 4 * s) : remaining - offset;
+        if (sizes[s] > remaining - offset) error("decodeBlock: block data is corrupt");
+        streams[s] = p + offset;
+        offset += sizes[s];
+    }
+    decodeSymbolsX4(tables, streams, sizes, output, length);
+}
+
+/*
+ * Decodes one block: raw and run blocks are copied or filled, tANS blocks go to decodeTans, and
+ * Huffman blocks rebuild their codes (one, or an order-1 block's several and its context map)
+ * from the stored lengths and decode the payload. A checksummed block's checksum is checked
+ * first, and the rest of it is then decoded as the type without the flag.
+ * @header: the block's header
+ * @payload: the header.payloadLength bytes following the header
+ * @output: where the header.rawLength decoded bytes go
+ */
+void decodeBlock(const BlockHeader& header, const unsigned char* payload, unsigned char* output) {
+    if (header.type & BLOCK_FLAG_CHECKSUM) {
+        if (header.payloadLength < (uint32_t) BLOCK_CHECKSUM_BYTES) error("decodeBlock: block is truncated");
+        BlockHeader unchecked = header;
+        unchecked.type &= ~BLOCK_FLAG_CHECKSUM;
+        unchecked.payloadLength -= BLOCK_CHECKSUM_BYTES;
+        if (crc32c(payload, unchecked.payloadLength) != readUint32(payload + unchecked.payloadLength)) {
+            error("decodeBlock: block checksum does not match");
+        }
+        decodeBlock(unchecked, payload, output);
+        return;
+    }
+    if (header.type == BLOCK_RAW) {
+        if (header.payloadLength != header.rawLength) error("decodeBlock: block data is corrupt");
+        memcpy(output, payload, header.rawLength);
+        return;
+    } else if (header.type == BLOCK_RUN) {
+        if (header.payloadLength != 1) error("decodeBlock: block data is corrupt");
+        memset(output, payload[0], header.rawLength);
+        return;
+    } else if (header.type == BLOCK_TANS) {
+        decodeTans(payload, header.payloadLength, output, header.rawLength);
+        return;
+    }
+    bool contextCoded = header.type == BLOCK_ORDER1 || header.type == BLOCK_ORDER1_X4;
+    if (!contextCoded && header.type != BLOCK_HUFFMAN && header.type != BLOCK_HUFFMAN_X4) {
+        error("decodeBlock: unknown block type");
+    }
+    bool interleaved = header.type == BLOCK_HUFFMAN_X4 || header.type == BLOCK_ORDER1_X4;
+    int numTables = 1;
+    unsigned char contextMap[256] = {0};
+    size_t used = 0;
+    if (contextCoded) {
+        if (header.payloadLength < (uint32_t) (1 + CONTEXT_MAP_BYTES)) error("decodeBlock: block is truncated");
+        numTables = payload[0] + 1;
+        if (numTables > MAX_CONTEXT_TABLES) error("decodeBlock: block data is corrupt");
+        for (int context = 0; context < 256; context++) {
+            contextMap[context] = (payload[1 + context / 2] >> (4 * (context & 1))) & 0x0f;
+            if (contextMap[context] >= numTables) error("decodeBlock: block data is corrupt");
+        }
+        used = 1 + CONTEXT_MAP_BYTES;
+    }
+    HuffmanCode codes[MAX_CONTEXT_TABLES];
+    HuffmanDecodeTable tables[MAX_CONTEXT_TABLES];
+    int maxTableBits = 1;
+    for (int t = 0; t < numTables; t++) {
+        int lengths[256];
+        used += readCodeLengths(payload + used, header.payloadLength - used, lengths);
+        codes[t].build(lengths, 256);
+        if (codes[t].maxLength() > MAX_BLOCK_CODE_LENGTH) error("decodeBlock: block data is corrupt");
+        tables[t].build(codes[t]);
+        maxTableBits = max(maxTableBits, tables[t].tableBits());
+    }
+
+    const unsigned char* p = payload + used;
+    size_t remaining = header.payloadLength - used;
+    if (contextCoded) {
+        ContextTables contextTables;
+        for (int context = 0; context < 256; context++) {
+            contextTables.tables[context] = &tables[contextMap[context]];
+        }
+        contextTables.maxTableBits = maxTableBits;
+        decodeStreams(contextTables, p, remaining, interleaved, output, header.rawLength);
+    } else {
+        SingleTable singleTable = {&tables[0]};
+        decodeStreams(singleTable, p, remaining, interleaved, output, header.rawLength);
+    }
+}
+
+/*
+ * Reads the input a block at a time and writes each encoded block as soon as it is done.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ * @options: the compression settings
+ */
+void compressBlocks(istream& input, obitstream& output, const BlockOptions& options) {
+    string encoded;
+    writeStreamHeader(encoded, options);
+    output.write(encoded.data(), encoded.size());
+    Vector<BlockIndexEntry> index;
+    BlockIndexEntry position = {STREAM_HEADER_BYTES, 0};
+    unique_ptr<char[]> buffer(new char[options.blockSize]);
+    while (true) {
+        input.read(buffer.get(), options.blockSize);
+        size_t length = (size_t) input.gcount();
+        if (length == 0) break;
+        encoded.clear();
+        encodeBlock((const unsigned char*) buffer.get(), length, options, encoded);
+        output.write(encoded.data(), encoded.size());
+        if (options.indexed) index.add(position);
+        position.compressedOffset += encoded.size();
+        position.rawOffset += length;
+        if (length < (size_t) options.blockSize) break;
+    }
+    encoded.clear();
+    appendEndBlock(encoded);
+    if (options.indexed) {
+        index.add(position);
+        appendBlockIndex(encoded, index, position.compressedOffset + BLOCK_HEADER_BYTES);
+    }
+    output.write(encoded.data(), encoded.size());
+    output.flush();
+}
+
+/*
+ * Reads and decodes one block at a time until the end marker.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressBlocks(ibitstream& input, ostream& output) {
+    BlockOptions options;
+    readStreamHeader(input, options);
+    string payload;
+    string decoded;
+    BlockHeader header;
+    while (readBlockHeader(input, header)) {
+        if (header.rawLength > (uint32_t) options.blockSize || header.payloadLength > (uint32_t) MAX_BLOCK_SIZE * 2
+                || (options.checksummed && !(header.type & BLOCK_FLAG_CHECKSUM))) {
+            error("decompressBlocks: block header is corrupt");
+        }
+        payload.resize(header.payloadLength);
+        input.read(&payload[0], header.payloadLength);
+        if ((size_t) input.gcount() != header.payloadLength) {
+            error("decompressBlocks: compressed stream is truncated");
+        }
+        if (header.type == BLOCK_RAW && header.payloadLength == header.rawLength) {
+            output.write(payload.data(), payload.size()); //already the decoded bytes
+            continue;
+        }
+        decoded.resize(header.rawLength);
+        decodeBlock(header, (const unsigned char*) payload.data(), (unsigned char*) &decoded[0]);
+        output.write(decoded.data(), decoded.size());
+    }
+}
+
+void appendBlockIndex(string& output, const Vector<BlockIndexEntry>& index, uint64_t indexOffset) {
+    for (int i = 0; i < index.size(); i++) {
+        appendUint64(output, index[i].compressedOffset);
+        appendUint64(output, index[i].rawOffset);
+    }
+    appendUint32(output, (uint32_t) index.size());
+    appendUint64(output, indexOffset);
+    output.append(INDEX_MAGIC, 4);
+}
+
+/*
+ * Finds the index through the trailer at the end of input and checks that it describes a
+ * sensible sequence of blocks before handing it out.
+ * @input: a stream whose last bytes are an indexed block-compressed stream
+ * @index: where the entries are stored, with compressed offsets as positions in input
+ * @options: where the stream's settings from its header are stored
+ */
+void readBlockIndex(istream& input, Vector<BlockIndexEntry>& index, BlockOptions& options) {
+    index.clear();
+    input.clear();
+    input.seekg(0, ios::end);
+    streamoff end = input.tellg();
+    unsigned char trailer[INDEX_TRAILER_BYTES];
+    if (end < STREAM_HEADER_BYTES + BLOCK_HEADER_BYTES + INDEX_ENTRY_BYTES + INDEX_TRAILER_BYTES) {
+        error("readBlockIndex: stream has no block index");
+    }
+    input.seekg(end - INDEX_TRAILER_BYTES);
+    input.read((char*) trailer, INDEX_TRAILER_BYTES);
+    if (input.gcount() != INDEX_TRAILER_BYTES || memcmp(trailer + 12, INDEX_MAGIC, 4) != 0) {
+        error("readBlockIndex: stream has no block index");
+    }
+    uint32_t count = readUint32(trailer);
+    uint64_t indexOffset = readUint64(trailer + 4);
+    uint64_t indexBytes = (uint64_t) count * INDEX_ENTRY_BYTES;
+    uint64_t indexEnd = (uint64_t) (end - INDEX_TRAILER_BYTES);
+    if (count < 1 || indexBytes > indexEnd || indexOffset > indexEnd - indexBytes) {
+        error("readBlockIndex: block index is corrupt");
+    }
+    uint64_t streamStart = indexEnd - indexBytes - indexOffset;
+
+    input.seekg((streamoff) streamStart);
+    readStreamHeader(input, options);
+    if (!options.indexed) error("readBlockIndex: block index is corrupt");
+
+    string bytes(indexBytes, '\0');
+    input.seekg((streamoff) (indexEnd - indexBytes));
+    input.read(&bytes[0], indexBytes);
+    if ((uint64_t) input.gcount() != indexBytes) error("readBlockIndex: block index is truncated");
+    const unsigned char* p = (const unsigned char*) bytes.data();
+    BlockIndexEntry previous = {0, 0};
+    for (uint32_t i = 0; i < count; i++) {
+        BlockIndexEntry entry;
+        entry.compressedOffset = readUint64(p + i * INDEX_ENTRY_BYTES);
+        entry.rawOffset = readUint64(p + i * INDEX_ENTRY_BYTES + 8);
+        bool valid = i == 0
+                ? entry.compressedOffset == (uint64_t) STREAM_HEADER_BYTES && entry.rawOffset == 0
+                : entry.compressedOffset > previous.compressedOffset + BLOCK_HEADER_BYTES
+                  && entry.rawOffset > previous.rawOffset
+                  && entry.rawOffset - previous.rawOffset <= (uint64_t) options.blockSize;
+        if (i == count - 1 && entry.compressedOffset + BLOCK_HEADER_BYTES != indexOffset) valid = false;
+        if (!valid) {
+            error("readBlockIndex: block index is corrupt");
+        }
+        previous = entry;
+        entry.compressedOffset += streamStart;
+        index.add(entry);
+    }
+}
+
+void decompressRange(istream& input, uint64_t offset, uint64_t length, ostream& output) {
+    Vector<BlockIndexEntry> index;
+    BlockOptions options;
+    readBlockIndex(input, index, options);
+    decompressRange(input, index, options, offset, length, output);
+}
+
+/*
+ * Binary searches the index for the first block overlapping the range, then decodes blocks until
+ * the range is covered, writing only the requested part of each.
+ * @input: the stream the index was read from
+ * @index: the stream's index from readBlockIndex
+ * @options: the stream's settings from readBlockIndex
+ * @offset: position in the decoded data of the first byte wanted
+ * @length: number of bytes wanted
+ * @output: where the decoded bytes go
+ */
+void decompressRange(istream& input, const Vector<BlockIndexEntry>& index, const BlockOptions& options,
+                     uint64_t offset, uint64_t length, ostream& output) {
+    uint64_t rawSize = index[index.size() - 1].rawOffset;
+    if (offset >= rawSize || length == 0) return;
+    uint64_t rangeEnd = length > rawSize - offset ? rawSize : offset + length;
+
+    int low = 0;
+    int high = index.size() - 2; //the last entry is the end marker
+    while (low < high) { //find the last block starting at or before offset
+        int middle = (low + high + 1) / 2;
+        if (index[middle].rawOffset <= offset) low = middle;
+        else high = middle - 1;
+    }
+
+    string payload;
+    string decoded;
+    input.clear();
+    for (int i = low; i < index.size() - 1 && index[i].rawOffset < rangeEnd; i++) {
+        input.seekg((streamoff) index[i].compressedOffset);
+        BlockHeader header;
+        if (!readBlockHeader(input, header)
+                || header.rawLength != index[i + 1].rawOffset - index[i].rawOffset
+                || header.payloadLength != index[i + 1].compressedOffset - index[i].compressedOffset
+                                           - BLOCK_HEADER_BYTES) {
+            error("decompressRange: block header does not match the index");
+        }
+        if (options.checksummed && !(header.type & BLOCK_FLAG_CHECKSUM)) {
+            error("decompressRange: block header is corrupt");
+        }
+        payload.resize(header.payloadLength);
+        input.read(&payload[0], header.payloadLength);
+        if ((size_t) input.gcount() != header.payloadLength) {
+            error("decompressRange: compressed stream is truncated");
+        }
+        decoded.resize(header.rawLength);
+        decodeBlock(header, (const unsigned char*) payload.data(), (unsigned char*) &decoded[0]);
+        uint64_t first = max(offset, index[i].rawOffset) - index[i].rawOffset;
+        uint64_t last = min(rangeEnd, index[i + 1].rawOffset) - index[i].rawOffset;
+        output.write(decoded.data() + first, last - first);
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the blockcodec.h file which declares the block-based compressed format. Instead of
+ * one frequency table and one bit stream for the whole input, the input is cut into blocks and
+ * each block gets its own length-limited canonical code (stored as code lengths) and its own
+ * byte-aligned payload. Blocks can be decoded independently and with table lookups only.
+ *
+ * Stream layout (all integers little-endian):
+ *   stream header: "HUFB", version byte, flags byte, block size (uint32)
+ *   each block:    block header (type byte, decoded length uint32, payload length uint32), payload
+ *   end:           a block header of type BLOCK_END with both lengths 0
+ *   index:         only if the stream header's STREAM_FLAG_INDEX flag is set: one entry per block
+ *                  plus one for the end marker (compressed offset uint64, decoded offset uint64,
+ *                  both from the start of the stream), then a trailer (number of entries uint32,
+ *                  offset of the index uint64, "HFBI"). The trailer is at the very end of the
+ *                  stream, so a reader can find the index with one seek and then jump straight
+ *                  to the blocks that hold any range of the decoded data.
+ *
+ * A BLOCK_HUFFMAN payload is the code lengths (a byte holding the number of coded characters
+ * minus one, then two 4-bit lengths per byte) followed by the bits of every character in order.
+ * A BLOCK_HUFFMAN_X4 payload splits the block into four equal quarters that are coded as four
+ * separate bit streams: code lengths, a jump table of the first three streams' sizes (uint32s),
+ * then the four streams. A decoder can then advance four independent cursors at once.
+ * A BLOCK_RAW payload is the block's bytes as they are, used when coding would not save at least
+ * 1/RAW_SAVINGS_DIVISOR of the block (random or already-compressed data), and a BLOCK_RUN
+ * payload is the single byte value that the whole block repeats. A BLOCK_TANS payload is the
+ * block coded with tANS instead of Huffman (see tans.h).
+ * BLOCK_ORDER1 and BLOCK_ORDER1_X4 payloads are laid out like BLOCK_HUFFMAN and BLOCK_HUFFMAN_X4,
+ * except that each character is coded with one of several codes, picked by the character before
+ * it (0 at the start of each stream). In place of the code lengths they hold: the number of codes
+ * minus one (byte), a context map giving the code used after each of the 256 characters (4 bits
+ * each, two per byte), then every code's lengths as above.
+ * Which coder is used is the compressor's choice (BlockOptions::backend), and a stream may mix
+ * block types freely.
+ * A block whose type has BLOCK_FLAG_CHECKSUM set ends its payload with 4 more bytes (counted in
+ * the payload length): the CRC-32C (checksum.h) of the rest of the payload, which is that of the
+ * type without the flag. decodeBlock checks it before decoding, so a damaged block is reported
+ * instead of decoding to garbage. Streams with STREAM_FLAG_CHECKSUM set have it on every block.
+ */
+
+#ifndef _blockcodec_h
+#define _blockcodec_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "bitstream.h"
+#include "vector.h"
+using namespace std;
+
+class HuffmanDecodeTable;
+
+const int DEFAULT_BLOCK_SIZE = 1 << 17;        // 128 KB of input per block
+const int MAX_BLOCK_SIZE = 1 << 26;            // largest block size a stream may declare
+const int DEFAULT_BLOCK_CODE_LENGTH = 11;      // 2K-entry decode tables stay in L1 cache
+const int MAX_BLOCK_CODE_LENGTH = 15;          // code lengths are stored in 4 bits
+const int INTERLEAVE_MIN_BYTES = 1024;         // smaller blocks aren't worth four streams
+const int STREAM_HEADER_BYTES = 10;
+const int BLOCK_HEADER_BYTES = 9;
+const int INDEX_ENTRY_BYTES = 16;
+const int INDEX_TRAILER_BYTES = 16;
+const int RAW_SAVINGS_DIVISOR = 32;            // code a block only if that saves over 1/32 of it
+const int STREAM_FLAG_INDEX = 1;               // the stream ends with a block index
+const int STREAM_FLAG_CHECKSUM = 2;            // every block ends with a checksum
+const int BLOCK_FLAG_CHECKSUM = 0x80;          // set in a block's type when its payload ends with a checksum
+const int BLOCK_CHECKSUM_BYTES = 4;
+const int MAX_CONTEXT_TABLES = 16;             // codes in an order-1 block (context map entries are 4 bits)
+
+enum BlockType {
+    BLOCK_END = 0,
+    BLOCK_HUFFMAN = 1,
+    BLOCK_HUFFMAN_X4 = 2,
+    BLOCK_RAW = 3,
+    BLOCK_RUN = 4,
+    BLOCK_TANS = 5,
+    BLOCK_ORDER1 = 6,
+    BLOCK_ORDER1_X4 = 7
+};
+
+/*
+ * The entropy coder used for blocks that are worth coding.
+ */
+enum EntropyBackend {
+    BACKEND_HUFFMAN,   // length-limited canonical Huffman codes (one or four streams)
+    BACKEND_TANS,      // table-based ANS: slower to encode, closer to the entropy on skewed data
+    BACKEND_ORDER1     // Huffman codes chosen by the previous character, for blocks where that is
+                       // smaller than one code (structured text, telemetry); slower to encode
+};
+
+/*
+ * Settings for compressBlocks/encodeBlock. The defaults are a good general choice.
+ */
+struct BlockOptions {
+    int blockSize;       // bytes of input per block
+    int maxCodeLength;   // longest Huffman code (8 to 15; 256 characters need at least 8)
+    bool interleaved;    // use four interleaved streams for blocks of INTERLEAVE_MIN_BYTES or more
+    bool indexed;        // write a block index after the end marker so ranges can be decoded directly
+    bool checksummed;    // end every block with a checksum of its payload
+    EntropyBackend backend;
+    BlockOptions();
+};
+
+/*
+ * The fixed-size header in front of every block's payload.
+ */
+struct BlockHeader {
+    int type;                // one of the BlockType values, possibly with BLOCK_FLAG_CHECKSUM
+    uint32_t rawLength;      // number of bytes the block decodes to
+    uint32_t payloadLength;  // number of bytes of payload after the header
+};
+
+/*
+ * Where one block starts, both in the compressed stream and in the decoded data.
+ */
+struct BlockIndexEntry {
+    uint64_t compressedOffset;  // position of the block's header
+    uint64_t rawOffset;         // position of the block's first decoded byte
+};
+
+/*
+ * Compresses the whole input into the block format, one block at a time, so memory use is
+ * bounded by the block size however large the input is.
+ */
+void compressBlocks(istream& input, obitstream& output, const BlockOptions& options = BlockOptions());
+
+/*
+ * Decompresses a stream written by compressBlocks. Throws an error if the data is not
+ * in the block format or is damaged (which is always noticed in checksummed streams).
+ */
+void decompressBlocks(ibitstream& input, ostream& output);
+
+/*
+ * Reads the block index of an indexed stream that ends at the end of input, and the settings
+ * from the stream's header. The entries' compressed offsets are converted to positions in input
+ * (so the stream may be embedded in a larger file), and the last entry is the end marker, whose
+ * rawOffset is the decoded size. Throws an error if the stream has no index or the index is damaged.
+ */
+void readBlockIndex(istream& input, Vector<BlockIndexEntry>& index, BlockOptions& options);
+
+/*
+ * Decodes length bytes of the original data starting at offset from an indexed stream, reading
+ * and decoding only the blocks that overlap that range. The range is clipped to the end of the
+ * data. The second version reuses an index and settings already loaded by readBlockIndex, which
+ * saves two seeks per call when serving many ranges from the same stream. In a checksummed stream
+ * every block read must carry its checksum, as in decompressBlocks.
+ */
+void decompressRange(istream& input, uint64_t offset, uint64_t length, ostream& output);
+void decompressRange(istream& input, const Vector<BlockIndexEntry>& index, const BlockOptions& options,
+                     uint64_t offset, uint64_t length, ostream& output);
+
+/*
+ * Building blocks for drivers that do their own I/O. writeStreamHeader/readStreamHeader handle
+ * the stream header, and parseStreamHeader reads it from memory; encodeBlock appends one complete
+ * block (header and payload) to output; readBlockHeader reads a block header, returning false at
+ * the end marker; parseBlockHeader does the same from memory; decodeBlock decodes a payload into
+ * header.rawLength bytes of output; appendBlockIndex appends the index and trailer, given the
+ * entries (with offsets from the start of the stream, ending with the end marker's) and the
+ * offset at which the index will start.
+ */
+void writeStreamHeader(string& output, const BlockOptions& options);
+void readStreamHeader(istream& input, BlockOptions& options);
+void parseStreamHeader(const unsigned char* bytes, BlockOptions& options);
+void encodeBlock(const unsigned char* data, size_t length, const BlockOptions& options, string& output);
+bool readBlockHeader(istream& input, BlockHeader& header);
+void parseBlockHeader(const unsigned char* bytes, BlockHeader& header);
+void appendEndBlock(string& output);
+void decodeBlock(const BlockHeader& header, const unsigned char* payload, unsigned char* output);
+void appendBlockIndex(string& output, const Vector<BlockIndexEntry>& index, uint64_t indexOffset);
+
+/*
+ * Pieces for formats that keep a code outside of any block (archive.h's shared tables).
+ * writeCodeLengths stores a code's lengths as in a BLOCK_HUFFMAN payload and readCodeLengths
+ * loads them, returning the number of bytes they took; decodeBitStream decodes count characters
+ * from one byte-aligned bit stream with a single table.
+ */
+void writeCodeLengths(string& output, const int lengths[256]);
+size_t readCodeLengths(const unsigned char* p, size_t available, int lengths[256]);
+void decodeBitStream(const HuffmanDecodeTable& table, const unsigned char* bits, size_t numBytes,
+                     unsigned char* output, size_t count);
+
+#endif
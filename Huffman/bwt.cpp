@@ -0,0 +1,608 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the Burrows-Wheeler codec declared in bwt.h. The suffix array
+ * comes from SA-IS: the suffixes are split into S-type (smaller than the next suffix) and L-type
+ * (larger), the leftmost S-type ones (LMS) are sorted by recursing on a string of half the length
+ * at most, and every other suffix is then induced into place with two scans of the array. The
+ * transformed block is move-to-front coded with zero runs written in bijective base 2 (RUNA/RUNB,
+ * as in bzip2) and coded with several canonical Huffman tables, each group of symbols using the
+ * table that codes it in the fewest bits.
+ */
+
+#include "bwt.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "error.h"
+#include "huffmancode.h"
+
+static const char BWT_MAGIC[] = "HBWT";
+static const int BWT_VERSION = 1;
+static const int BWT_HEADER_BYTES = 5;
+static const int RUNA = 0;
+static const int RUNB = 1;
+static const int MAX_ALPHABET = 258;      // RUNA, RUNB, move-to-front positions 1-255, end of block
+static const int MAX_SELECTORS = (BWT_BLOCK_BYTES + BWT_GROUP_SIZE) / BWT_GROUP_SIZE;
+static const int TABLE_ITERATIONS = 4;    // rounds of reassigning groups to tables and rebuilding them
+
+/*
+ * Returns true if position i starts a leftmost S-type suffix, i.e. it is S-type and i - 1 is L-type.
+ */
+static inline bool isLMS(const unsigned char types[], int i) {
+    return i > 0 && types[i] && !types[i - 1];
+}
+
+/*
+ * Stores where each character's bucket in the suffix array starts (or ends, one past its last slot).
+ */
+template <typename Symbol>
+static void findBuckets(const Symbol text[], int length, int alphabetSize, int buckets[], bool ends) {
+    for (int k = 0; k < alphabetSize; k++) {
+        buckets[k] = 0;
+    }
+    for (int i = 0; i < length; i++) {
+        buckets[text[i]]++;
+    }
+    int sum = 0;
+    for (int k = 0; k < alphabetSize; k++) {
+        sum += buckets[k];
+        buckets[k] = ends ? sum : sum - buckets[k];
+    }
+}
+
+/*
+ * Given the LMS suffixes at the ends of their buckets, induces the L-type suffixes from left to
+ * right and then the S-type suffixes from right to left. The empty suffix at length sorts before
+ * everything, so the L-type suffix just before it goes first.
+ */
+template <typename Symbol>
+static void induceSort(const Symbol text[], int length, int alphabetSize, const unsigned char types[],
+                       int buckets[], int sa[]) {
+    findBuckets(text, length, alphabetSize, buckets, false);
+    sa[buckets[text[length - 1]]++] = length - 1;
+    for (int i = 0; i < length; i++) {
+        int j = sa[i] - 1;
+        if (j >= 0 && !types[j]) sa[buckets[text[j]]++] = j;
+    }
+    findBuckets(text, length, alphabetSize, buckets, true);
+    for (int i = length - 1; i >= 0; i--) {
+        int j = sa[i] - 1;
+        if (j >= 0 && types[j]) sa[--buckets[text[j]]] = j;
+    }
+}
+
+/*
+ * SA-IS over text[0 .. length-1], whose characters are all below alphabetSize. The end of the text
+ * acts as a character smaller than any other. The reduced problem lives inside sa itself: its
+ * suffix array in the front half and its text in the back.
+ */
+template <typename Symbol>
+static void suffixArray(const Symbol text[], int length, int alphabetSize, int sa[]) {
+    if (length <= 1) {
+        if (length == 1) sa[0] = 0;
+        return;
+    }
+    unsigned char* types = new unsigned char[length]; //1 for S-type
+    types[length - 1] = 0;
+    for (int i = length - 2; i >= 0; i--) {
+        types[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && types[i + 1]);
+    }
+    int* buckets = new int[alphabetSize];
+
+    //sort the LMS substrings by inducing from their positions in any order
+    findBuckets(text, length, alphabetSize, buckets, true);
+    for (int i = 0; i < length; i++) {
+        sa[i] = -1;
+    }
+    for (int i = 1; i < length; i++) {
+        if (isLMS(types, i)) sa[--buckets[text[i]]] = i;
+    }
+    induceSort(text, length, alphabetSize, types, buckets, sa);
+
+    //name them: equal LMS substrings get the same name, in sorted order
+    int numLMS = 0;
+    for (int i = 0; i < length; i++) {
+        if (isLMS(types, sa[i])) sa[numLMS++] = sa[i];
+    }
+    for (int i = numLMS; i < length; i++) {
+        sa[i] = -1;
+    }
+    int numNames = 0;
+    int previous = -1;
+    for (int i = 0; i < numLMS; i++) {
+        int pos = sa[i];
+        bool differ = false;
+        for (int d = 0; ; d++) {
+            if (previous < 0 || pos + d == length || previous + d == length
+                    || text[pos + d] != text[previous + d] || types[pos + d] != types[previous + d]) {
+                differ = true;
+                break;
+            }
+            if (d > 0 && (isLMS(types, pos + d) || isLMS(types, previous + d))) break;
+        }
+        if (differ) {
+            numNames++;
+            previous = pos;
+        }
+        sa[numLMS + pos / 2] = numNames - 1; //LMS positions are never adjacent, so pos / 2 is free
+    }
+    for (int i = length - 1, j = length - 1; i >= numLMS; i--) {
+        if (sa[i] >= 0) sa[j--] = sa[i];
+    }
+
+    //sort the LMS suffixes: recurse unless every name is already different
+    int* reduced = sa + length - numLMS;
+    if (numNames < numLMS) {
+        suffixArray(reduced, numLMS, numNames, sa);
+    } else {
+        for (int i = 0; i < numLMS; i++) {
+            sa[reduced[i]] = i;
+        }
+    }
+
+    //put the sorted LMS suffixes at their bucket ends and induce the rest
+    for (int i = 1, j = 0; i < length; i++) {
+        if (isLMS(types, i)) reduced[j++] = i;
+    }
+    for (int i = 0; i < numLMS; i++) {
+        sa[i] = reduced[sa[i]];
+    }
+    for (int i = numLMS; i < length; i++) {
+        sa[i] = -1;
+    }
+    findBuckets(text, length, alphabetSize, buckets, true);
+    for (int i = numLMS - 1; i >= 0; i--) {
+        int pos = sa[i];
+        sa[i] = -1;
+        sa[--buckets[text[pos]]] = pos;
+    }
+    induceSort(text, length, alphabetSize, types, buckets, sa);
+    delete[] types;
+    delete[] buckets;
+}
+
+void buildSuffixArray(const unsigned char* text, int length, int sa[]) {
+    suffixArray(text, length, 256, sa);
+}
+
+/*
+ * Builds length-limited code lengths for the given symbol counts. Every symbol gets a code, even
+ * one no group of this table uses yet, so a table can be picked for any group.
+ */
+static void buildCodeLengths(const uint64_t counts[], int alphabetSize, int lengths[]) {
+    uint64_t weights[MAX_ALPHABET];
+    for (int i = 0; i < alphabetSize; i++) {
+        weights[i] = counts[i] + 1;
+    }
+    HuffmanPool pool;
+    pool.build(weights, alphabetSize);
+    pool.codeLengths(lengths, alphabetSize, BWT_MAX_CODE_LENGTH);
+}
+
+/*
+ * Picks a table for every group of symbols and the tables' code lengths. The tables start out
+ * each covering a slice of the alphabet with about the same number of symbols, then every round
+ * gives each group to its cheapest table and rebuilds the tables from the groups they got.
+ * Returns the number of tables.
+ */
+static int chooseTables(const uint16_t symbols[], int count, int alphabetSize,
+                        unsigned char selectors[], int lengths[][MAX_ALPHABET]) {
+    int numTables = count < 200 ? 2 : count < 600 ? 3 : count < 1200 ? 4 : count < 2400 ? 5 : 6;
+    uint64_t counts[BWT_MAX_TABLES][MAX_ALPHABET];
+    for (int v = 0; v < alphabetSize; v++) {
+        counts[0][v] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        counts[0][symbols[i]]++;
+    }
+    int remaining = count;
+    int first = 0;
+    for (int t = numTables; t > 0; t--) {
+        int target = remaining / t;
+        int last = first - 1;
+        int covered = 0;
+        while (covered < target && last < alphabetSize - 1) {
+            last++;
+            covered += (int) counts[0][last];
+        }
+        for (int v = 0; v < alphabetSize; v++) {
+            lengths[t - 1][v] = v >= first && v <= last ? 0 : BWT_MAX_CODE_LENGTH;
+        }
+        first = last + 1;
+        remaining -= covered;
+    }
+
+    int numGroups = (count + BWT_GROUP_SIZE - 1) / BWT_GROUP_SIZE;
+    for (int iteration = 0; iteration < TABLE_ITERATIONS; iteration++) {
+        for (int t = 0; t < numTables; t++) {
+            for (int v = 0; v < alphabetSize; v++) {
+                counts[t][v] = 0;
+            }
+        }
+        for (int g = 0; g < numGroups; g++) {
+            int start = g * BWT_GROUP_SIZE;
+            int end = min(start + BWT_GROUP_SIZE, count);
+            int best = 0;
+            int bestCost = 0;
+            for (int t = 0; t < numTables; t++) {
+                int cost = 0;
+                for (int i = start; i < end; i++) {
+                    cost += lengths[t][symbols[i]];
+                }
+                if (t == 0 || cost < bestCost) {
+                    best = t;
+                    bestCost = cost;
+                }
+            }
+            selectors[g] = (unsigned char) best;
+            for (int i = start; i < end; i++) {
+                counts[best][symbols[i]]++;
+            }
+        }
+        for (int t = 0; t < numTables; t++) {
+            buildCodeLengths(counts[t], alphabetSize, lengths[t]);
+        }
+    }
+    return numTables;
+}
+
+/*
+ * Move-to-front codes a transformed block over the bytes that occur in it, writing runs of
+ * position 0 as RUNA/RUNB digits and every other position p as the symbol p + 1.
+ * @transformed: the block's last column
+ * @mtf: the bytes in use, in increasing order
+ * @numInUse: how many there are
+ * @symbols: where the symbols go, ending with the end-of-block symbol numInUse + 1
+ * Returns the number of symbols.
+ */
+static int moveToFront(const unsigned char transformed[], int length, unsigned char mtf[], int numInUse,
+                       uint16_t symbols[]) {
+    int count = 0;
+    int run = 0;
+    for (int i = 0; i <= length; i++) {
+        if (i < length && transformed[i] == mtf[0]) {
+            run++;
+            continue;
+        }
+        if (run > 0) { //digits of run - 1 in bijective base 2, lowest first
+            int pending = run - 1;
+            while (true) {
+                symbols[count++] = (uint16_t) ((pending & 1) ? RUNB : RUNA);
+                if (pending < 2) break;
+                pending = (pending - 2) >> 1;
+            }
+            run = 0;
+        }
+        if (i == length) break;
+        unsigned char ch = transformed[i];
+        int p = 1;
+        unsigned char moving = mtf[0];
+        while (mtf[p] != ch) { //shift everything before ch back one place as we look for it
+            unsigned char next = mtf[p];
+            mtf[p] = moving;
+            moving = next;
+            p++;
+        }
+        mtf[p] = moving;
+        mtf[0] = ch;
+        symbols[count++] = (uint16_t) (p + 1);
+    }
+    symbols[count++] = (uint16_t) (max(numInUse, 1) + 1);
+    return count;
+}
+
+/*
+ * Transforms, codes and writes one block.
+ * @block: the input bytes
+ * @length: how many there are (0 only for an empty input)
+ * @last: whether this is the stream's final block
+ * @sa, @transformed, @symbols: working arrays of BWT_BLOCK_BYTES (+ 1 for symbols) entries
+ * @writer: where the bits go
+ */
+static void writeBlock(const unsigned char block[], int length, bool last, int sa[],
+                       unsigned char transformed[], uint16_t symbols[], BitWriter& writer) {
+    //the last column of the sorted rotations of block + end marker, without the end marker itself
+    int primary = 0;
+    if (length > 0) {
+        buildSuffixArray(block, length, sa);
+        int out = 0;
+        transformed[out++] = block[length - 1]; //row 0 is the end marker's own rotation
+        for (int i = 0; i < length; i++) {
+            if (sa[i] == 0) {
+                primary = i + 1;
+            } else {
+                transformed[out++] = block[sa[i] - 1];
+            }
+        }
+    }
+
+    bool inUse[256] = {false};
+    for (int i = 0; i < length; i++) {
+        inUse[block[i]] = true;
+    }
+    unsigned char mtf[256];
+    int numInUse = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        if (inUse[ch]) mtf[numInUse++] = (unsigned char) ch;
+    }
+    int count = moveToFront(transformed, length, mtf, numInUse, symbols);
+    int alphabetSize = max(numInUse, 1) + 2;
+    unsigned char selectors[MAX_SELECTORS];
+    int lengths[BWT_MAX_TABLES][MAX_ALPHABET];
+    int numTables = chooseTables(symbols, count, alphabetSize, selectors, lengths);
+    int numGroups = (count + BWT_GROUP_SIZE - 1) / BWT_GROUP_SIZE;
+
+    writer.writeBit(last ? 1 : 0);
+    writer.writeBits(length, 20);
+    writer.writeBits(primary, 20);
+    int groupsInUse = 0;
+    for (int g = 0; g < 16; g++) {
+        for (int ch = g * 16; ch < g * 16 + 16; ch++) {
+            if (inUse[ch]) groupsInUse |= 1 << g;
+        }
+    }
+    writer.writeBits(groupsInUse, 16);
+    for (int g = 0; g < 16; g++) {
+        if (!(groupsInUse & (1 << g))) continue;
+        for (int ch = g * 16; ch < g * 16 + 16; ch++) {
+            writer.writeBit(inUse[ch] ? 1 : 0);
+        }
+    }
+    writer.writeBits(numTables, 3);
+    writer.writeBits(numGroups, 15);
+    unsigned char order[BWT_MAX_TABLES] = {0, 1, 2, 3, 4, 5};
+    for (int g = 0; g < numGroups; g++) { //move-to-front position of each selector, in unary
+        int p = 0;
+        while (order[p] != selectors[g]) {
+            p++;
+        }
+        memmove(order + 1, order, p);
+        order[0] = selectors[g];
+        for (int i = 0; i < p; i++) {
+            writer.writeBit(1);
+        }
+        writer.writeBit(0);
+    }
+    for (int t = 0; t < numTables; t++) { //code lengths as changes from the previous one
+        int current = lengths[t][0];
+        writer.writeBits(current, 5);
+        for (int v = 0; v < alphabetSize; v++) {
+            while (current < lengths[t][v]) {
+                writer.writeBits(1, 2); //1 then 0: one longer
+                current++;
+            }
+            while (current > lengths[t][v]) {
+                writer.writeBits(3, 2); //1 then 1: one shorter
+                current--;
+            }
+            writer.writeBit(0);
+        }
+    }
+
+    uint32_t bits[BWT_MAX_TABLES][MAX_ALPHABET];
+    for (int t = 0; t < numTables; t++) {
+        HuffmanCode code;
+        code.build(lengths[t], alphabetSize);
+        for (int v = 0; v < alphabetSize; v++) {
+            bits[t][v] = code.bits(v);
+        }
+    }
+    for (int g = 0; g < numGroups; g++) {
+        int t = selectors[g];
+        int end = min((g + 1) * BWT_GROUP_SIZE, count);
+        for (int i = g * BWT_GROUP_SIZE; i < end; i++) {
+            writer.writeBits(bits[t][symbols[i]], lengths[t][symbols[i]]);
+        }
+    }
+}
+
+/*
+ * Reads the input a block at a time and writes each one transformed and coded.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ */
+void compressBWT(istream& input, obitstream& output) {
+    output.write(BWT_MAGIC, 4);
+    output.put((char) BWT_VERSION);
+
+    //held by unique_ptr so an error thrown while coding doesn't leak them
+    unique_ptr<unsigned char[]> block(new unsigned char[BWT_BLOCK_BYTES]);
+    unique_ptr<unsigned char[]> transformed(new unsigned char[BWT_BLOCK_BYTES]);
+    unique_ptr<int[]> sa(new int[BWT_BLOCK_BYTES]);
+    unique_ptr<uint16_t[]> symbols(new uint16_t[BWT_BLOCK_BYTES + 1]);
+    BitWriter writer(output);
+    while (true) {
+        input.read((char*) block.get(), BWT_BLOCK_BYTES);
+        int length = (int) input.gcount();
+        bool last = length < BWT_BLOCK_BYTES;
+        writeBlock(block.get(), length, last, sa.get(), transformed.get(), symbols.get(), writer);
+        if (last) break;
+    }
+    writer.flush();
+}
+
+/*
+ * Reads the next code from the window using table, returning its symbol or -1 if the bits
+ * are not a valid code or the input has run out.
+ */
+static inline int readSymbol(BitReader& reader, const HuffmanDecodeTable& table) {
+    uint32_t entry = table.entry(reader.window());
+    int length = HuffmanDecodeTable::entryLength(entry);
+    if (length == 0 || length > reader.bitsAvailable()) return -1;
+    reader.consume(length);
+    return HuffmanDecodeTable::entrySymbol(entry);
+}
+
+/*
+ * Reads one block's header, tables and symbols and undoes the move-to-front and run coding.
+ * @transformed: where the block's last column goes
+ * @length, @primary, @last: set from the block header
+ * Returns false if the block is damaged.
+ */
+static bool readBlock(BitReader& reader, unsigned char transformed[], int& length, int& primary, bool& last,
+                      HuffmanCode codes[], HuffmanDecodeTable tables[]) {
+    int64_t lastBit = reader.readBit();
+    int64_t blockLength = reader.readBits(20);
+    int64_t primaryRow = reader.readBits(20);
+    int64_t groupsInUse = reader.readBits(16);
+    if (lastBit < 0 || blockLength < 0 || primaryRow < 0 || groupsInUse < 0) return false;
+    last = lastBit != 0;
+    length = (int) blockLength;
+    primary = (int) primaryRow;
+    if (length > BWT_BLOCK_BYTES || (length == 0 ? primary != 0 : primary < 1 || primary > length)) return false;
+    unsigned char mtf[256];
+    int numInUse = 0;
+    for (int g = 0; g < 16; g++) {
+        if (!(groupsInUse & (1 << g))) continue;
+        int64_t used = reader.readBits(16);
+        if (used < 0) return false;
+        for (int i = 0; i < 16; i++) {
+            if (used & (1 << i)) mtf[numInUse++] = (unsigned char) (g * 16 + i);
+        }
+    }
+    int alphabetSize = max(numInUse, 1) + 2;
+    int endOfBlock = alphabetSize - 1;
+
+    int64_t numTables = reader.readBits(3);
+    int64_t numGroups = reader.readBits(15);
+    if (numTables < 2 || numTables > BWT_MAX_TABLES || numGroups < 1 || numGroups > MAX_SELECTORS) return false;
+    unsigned char selectors[MAX_SELECTORS];
+    unsigned char order[BWT_MAX_TABLES] = {0, 1, 2, 3, 4, 5};
+    for (int g = 0; g < numGroups; g++) {
+        int p = 0;
+        while (true) {
+            int bit = reader.readBit();
+            if (bit < 0) return false;
+            if (bit == 0) break;
+            if (++p >= numTables) return false;
+        }
+        unsigned char selector = order[p];
+        memmove(order + 1, order, p);
+        order[0] = selector;
+        selectors[g] = selector;
+    }
+    for (int t = 0; t < numTables; t++) {
+        int lengths[MAX_ALPHABET];
+        int current = (int) reader.readBits(5);
+        for (int v = 0; v < alphabetSize; v++) {
+            while (true) {
+                if (current < 1 || current > BWT_MAX_CODE_LENGTH) return false;
+                int bit = reader.readBit();
+                if (bit < 0) return false;
+                if (bit == 0) break;
+                bit = reader.readBit();
+                if (bit < 0) return false;
+                current += bit ? -1 : 1;
+            }
+            lengths[v] = current;
+        }
+        codes[t].build(lengths, alphabetSize);
+        tables[t].build(codes[t]);
+    }
+
+    int pos = 0;
+    int run = 0;       //zero run being read
+    int runDigit = 1;  //value of the next RUNA; a RUNB is worth twice as much
+    for (int g = 0; ; g++) {
+        if (g == numGroups) return false; //ran out of groups before the end of the block
+        const HuffmanDecodeTable& table = tables[selectors[g]];
+        for (int i = 0; i < BWT_GROUP_SIZE; i++) {
+            reader.refill();
+            int symbol = readSymbol(reader, table);
+            if (symbol < 0) return false;
+            if (symbol <= RUNB) {
+                if (runDigit > BWT_BLOCK_BYTES) return false;
+                run += runDigit << symbol;
+                runDigit <<= 1;
+                continue;
+            }
+            if (run > 0) {
+                if (run > length - pos) return false;
+                memset(transformed + pos, mtf[0], run);
+                pos += run;
+                run = 0;
+                runDigit = 1;
+            }
+            if (symbol == endOfBlock) return pos == length;
+            if (pos == length) return false;
+            int p = symbol - 1;
+            unsigned char ch = mtf[p];
+            memmove(mtf + 1, mtf, p);
+            mtf[0] = ch;
+            transformed[pos++] = ch;
+        }
+    }
+}
+
+/*
+ * Undoes the transform. Row 0 of the sorted rotations starts with the end marker; scanning the
+ * last column links every row to the row of the rotation one character further on, and each
+ * entry packs that row with the row's first character. Following the links from the row of the
+ * original text spells it out in order.
+ * @transformed: the last column without the end marker, which belongs at row primary
+ * @links: working array of length + 1 entries
+ */
+static void inverseTransform(const unsigned char transformed[], int length, int primary,
+                             uint32_t links[], unsigned char output[]) {
+    int starts[256];
+    int counts[256] = {0};
+    for (int i = 0; i < length; i++) {
+        counts[transformed[i]]++;
+    }
+    int sum = 1;
+    for (int ch = 0; ch < 256; ch++) {
+        starts[ch] = sum;
+        sum += counts[ch];
+    }
+    links[0] = (uint32_t) primary << 8;
+    for (int row = 0, i = 0; row <= length; row++) {
+        if (row == primary) continue;
+        unsigned char ch = transformed[i++];
+        links[starts[ch]++] = (uint32_t) row << 8 | ch;
+    }
+    uint32_t row = links[0] >> 8;
+    for (int i = 0; i < length; i++) {
+        uint32_t link = links[row];
+        output[i] = (unsigned char) link;
+        row = link >> 8;
+    }
+}
+
+/*
+ * Decodes block after block, undoing the transform of each and writing it out.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressBWT(ibitstream& input, ostream& output) {
+    unsigned char header[BWT_HEADER_BYTES];
+    input.read((char*) header, BWT_HEADER_BYTES);
+    if (input.gcount() != BWT_HEADER_BYTES || memcmp(header, BWT_MAGIC, 4) != 0) {
+        error("decompressBWT: not a BWT-compressed stream");
+    }
+    if (header[4] != BWT_VERSION) {
+        error("decompressBWT: unsupported BWT stream version");
+    }
+
+    BitReader reader(input);
+    //held by unique_ptr so that corrupt code lengths, which make HuffmanCode::build throw, don't leak them
+    unique_ptr<unsigned char[]> transformed(new unsigned char[BWT_BLOCK_BYTES]);
+    unique_ptr<unsigned char[]> block(new unsigned char[BWT_BLOCK_BYTES]);
+    unique_ptr<uint32_t[]> links(new uint32_t[BWT_BLOCK_BYTES + 1]);
+    HuffmanCode codes[BWT_MAX_TABLES];
+    HuffmanDecodeTable tables[BWT_MAX_TABLES];
+    bool last = false;
+    bool ok = true;
+    while (ok && !last) {
+        int length = 0;
+        int primary = 0;
+        ok = readBlock(reader, transformed.get(), length, primary, last, codes, tables);
+        if (ok) {
+            inverseTransform(transformed.get(), length, primary, links.get(), block.get());
+            output.write((const char*) block.get(), length);
+        }
+    }
+    if (!ok) error("decompressBWT: compressed data is corrupt or truncated");
+}
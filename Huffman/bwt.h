@@ -0,0 +1,50 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the bwt.h file which declares the Burrows-Wheeler codec, the same pipeline bzip2 uses.
+ * Order-0 Huffman coding only sees how often each character occurs; the Burrows-Wheeler transform
+ * sorts every character by the text that follows it, so characters with similar contexts end up
+ * next to each other. Move-to-front then turns that locality into lots of small numbers and runs
+ * of zeros, the zero runs are written as binary run lengths, and what is left is Huffman coded.
+ *
+ * The transform of an n-byte block takes O(n) time: its suffix array is built with the SA-IS
+ * algorithm (induced sorting), and the inverse is one pass over a table of n + 1 entries.
+ *
+ * Stream layout: "HBWT", version byte, then blocks in one bit stream (first bit lowest). Each block
+ * is: a last-block bit, its length and the row of the original text in the sorted order (20 bits
+ * each), which bytes occur in it, the number of code tables and which table codes each group of
+ * BWT_GROUP_SIZE symbols, the tables' code lengths, and the coded symbols ending with an
+ * end-of-block symbol.
+ */
+
+#ifndef _bwt_h
+#define _bwt_h
+
+#include <iostream>
+#include "bitstream.h"
+using namespace std;
+
+const int BWT_BLOCK_BYTES = 900000;       // input transformed at once, as in bzip2 -9
+const int BWT_GROUP_SIZE = 50;            // symbols coded with the same table
+const int BWT_MAX_TABLES = 6;
+const int BWT_MAX_CODE_LENGTH = 15;
+
+/*
+ * Builds the suffix array of text: sa[i] is the start of the i-th smallest suffix of
+ * text[0 .. length-1]. A suffix that is a prefix of another one sorts first. Takes O(length)
+ * time, and its working memory besides sa is O(length) too: a byte per character, plus type and
+ * bucket arrays for the recursive calls, each on a string at most half as long as the one before.
+ */
+void buildSuffixArray(const unsigned char* text, int length, int sa[]);
+
+/*
+ * Compresses the input a block of up to BWT_BLOCK_BYTES at a time.
+ */
+void compressBWT(istream& input, obitstream& output);
+
+/*
+ * Decompresses a stream written by compressBWT. Throws an error if the data is not in the BWT
+ * format or is damaged.
+ */
+void decompressBWT(ibitstream& input, ostream& output);
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the bytes.h file which declares small helpers for reading and writing the fixed-size
+ * little-endian integers used in the headers of the block-based compressed formats, and the
+ * variable-length integers (7 bits per byte, low bits first, high bit set on every byte but the
+ * last) used where most values are small.
+ */
+
+#ifndef _bytes_h
+#define _bytes_h
+
+#include <cstdint>
+#include <string>
+using namespace std;
+
+inline void appendUint16(string& out, uint32_t value) {
+    out += (char) (value & 0xff);
+    out += (char) ((value >> 8) & 0xff);
+}
+
+inline void appendUint32(string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out += (char) ((value >> (8 * i)) & 0xff);
+    }
+}
+
+inline void appendUint64(string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out += (char) ((value >> (8 * i)) & 0xff);
+    }
+}
+
+inline void storeUint32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char) ((value >> (8 * i)) & 0xff);
+    }
+}
+
+inline uint32_t readUint16(const unsigned char* p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8;
+}
+
+inline uint32_t readUint32(const unsigned char* p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+inline uint64_t readUint64(const unsigned char* p) {
+    return (uint64_t) readUint32(p) | (uint64_t) readUint32(p + 4) << 32;
+}
+
+inline void appendVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char) ((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += (char) value;
+}
+
+/*
+ * Reads a variable-length integer at p into value and moves p past it. Returns false, leaving p
+ * alone, if it runs past end or is longer than any 64-bit value.
+ */
+inline bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p + shift / 7 < end; shift += 7) {
+        unsigned char byte = p[shift / 7];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            p += shift / 7 + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
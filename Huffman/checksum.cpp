@@ -0,0 +1,187 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements CRC-32C. The CRC instruction takes eight bytes at a time but
+ * has a latency of three cycles, so one chain of them runs at a third of the speed the
+ * instruction allows. Long inputs are therefore split into three parts whose CRCs are computed
+ * side by side in one loop and then joined with crc32cCombine. The software version looks up
+ * eight tables at once (slicing-by-8), handling eight bytes per step as well.
+ * Both work on the raw CRC register; crc32c adds the usual inversions before and after.
+ */
+
+#include "checksum.h"
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+static const uint32_t POLYNOMIAL = 0x82f63b78;        //the Castagnoli polynomial, bit-reversed
+static const size_t INTERLEAVE_MIN_BYTES = 1 << 12;  //below this, joining three CRCs costs more than it saves
+
+/*
+ * The software tables: table[k][b] is the CRC register change for byte b followed by k zero bytes.
+ */
+struct CrcTables {
+    uint32_t table[8][256];
+    uint32_t powers[64];   // x^(2^k) mod the polynomial, for crc32cCombine
+
+    CrcTables();
+};
+
+static uint32_t multiplyModP(uint32_t a, uint32_t b);
+
+CrcTables::CrcTables() {
+    for (int b = 0; b < 256; b++) {
+        uint32_t crc = b;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+        }
+        table[0][b] = crc;
+    }
+    for (int b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) {
+            table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+        }
+    }
+    powers[0] = 1u << 30; //x^1 (bit 31 is x^0 in the reversed order)
+    for (int k = 1; k < 64; k++) {
+        powers[k] = multiplyModP(powers[k - 1], powers[k - 1]);
+    }
+}
+
+/*
+ * Returns the tables, built on first use (C++11 makes that thread-safe).
+ */
+static const CrcTables& tables() {
+    static const CrcTables instance;
+    return instance;
+}
+
+/*
+ * Returns a * b modulo the polynomial, with both in the bit-reversed order CRCs use.
+ */
+static uint32_t multiplyModP(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t m = 1u << 31; m != 0; m >>= 1) {
+        if (a & m) product ^= b;
+        b = b & 1 ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
+
+/*
+ * Returns the register after running crc through length zero bytes, i.e. crc * x^(8 * length).
+ */
+static uint32_t shiftCrc(uint32_t crc, size_t length) {
+    const CrcTables& t = tables();
+    uint64_t bits = (uint64_t) length;
+    for (int k = 3; bits != 0; k++, bits >>= 1) { //x^(8n) = product of x^(2^k) over n's bits, k from 3
+        if (bits & 1) crc = multiplyModP(t.powers[k], crc);
+    }
+    return crc;
+}
+
+/*
+ * Slicing-by-8: one 8-byte load and eight lookups per step.
+ */
+static uint32_t crcSoftware(uint32_t crc, const unsigned char* p, size_t length) {
+    const CrcTables& t = tables();
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        uint32_t low = (uint32_t) word ^ crc;
+        uint32_t high = (uint32_t) (word >> 32);
+        crc = t.table[7][low & 0xff] ^ t.table[6][(low >> 8) & 0xff] ^ t.table[5][(low >> 16) & 0xff]
+            ^ t.table[4][low >> 24] ^ t.table[3][high & 0xff] ^ t.table[2][(high >> 8) & 0xff]
+            ^ t.table[1][(high >> 16) & 0xff] ^ t.table[0][high >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        crc = (crc >> 8) ^ t.table[0][(crc ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+#if defined(CRC32C_X86)
+#define CRC_TARGET __attribute__((target("sse4.2")))
+#define CRC_WORD(crc, word) ((uint32_t) _mm_crc32_u64(crc, word))
+#define CRC_BYTE(crc, byte) _mm_crc32_u8(crc, byte)
+#else
+#define CRC_TARGET
+#define CRC_WORD(crc, word) __crc32cd(crc, word)
+#define CRC_BYTE(crc, byte) __crc32cb(crc, byte)
+#endif
+
+static inline uint64_t loadWord(const unsigned char* p) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    return word;
+}
+
+/*
+ * The CRC instruction, eight bytes at a time; inputs of INTERLEAVE_MIN_BYTES or more are done as
+ * three interleaved parts.
+ */
+CRC_TARGET static uint32_t crcHardware(uint32_t crc, const unsigned char* p, size_t length) {
+    if (length >= INTERLEAVE_MIN_BYTES) {
+        size_t part = length / 24 * 8;
+        const unsigned char* p1 = p + part;
+        const unsigned char* p2 = p1 + part;
+        uint32_t crc1 = 0;
+        uint32_t crc2 = 0;
+        for (size_t i = 0; i < part; i += 8) {
+            crc = CRC_WORD(crc, loadWord(p + i));
+            crc1 = CRC_WORD(crc1, loadWord(p1 + i));
+            crc2 = CRC_WORD(crc2, loadWord(p2 + i));
+        }
+        crc = shiftCrc(crc, 2 * part) ^ shiftCrc(crc1, part) ^ crc2;
+        p += 3 * part;
+        length -= 3 * part;
+    }
+    while (length >= 8) {
+        crc = CRC_WORD(crc, loadWord(p));
+        p += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        crc = CRC_BYTE(crc, *p++);
+    }
+    return crc;
+}
+
+bool crc32cHardware() {
+#if defined(CRC32C_X86)
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return true;
+#endif
+}
+#else
+bool crc32cHardware() {
+    return false;
+}
+#endif
+
+uint32_t crc32c(const unsigned char* data, size_t length, uint32_t crc) {
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+    if (crc32cHardware()) return ~crcHardware(~crc, data, length);
+#endif
+    return ~crcSoftware(~crc, data, length);
+}
+
+/*
+ * The register for the joined data is crc1's register run through length2 more bytes, plus
+ * crc2's; the inversions cancel out, since both CRCs have them.
+ */
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, size_t length2) {
+    return shiftCrc(crc1, length2) ^ crc2;
+}
@@ -0,0 +1,34 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the checksum.h file which declares the CRC-32C (Castagnoli) checksum used to catch
+ * damaged data in the block format. CRC-32C is the variant with an instruction of its own on
+ * x86 (SSE4.2) and ARMv8, so with hardware support it runs at several bytes per cycle, far
+ * faster than any decoder produces data. Elsewhere a table-driven version is used, which gives
+ * the same results.
+ */
+
+#ifndef _checksum_h
+#define _checksum_h
+
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+/*
+ * Returns the CRC-32C of length bytes of data. To checksum data that arrives in pieces, pass
+ * each piece's result as crc for the next piece (0 for the first).
+ */
+uint32_t crc32c(const unsigned char* data, size_t length, uint32_t crc = 0);
+
+/*
+ * Returns the CRC-32C of two pieces of data joined together, given each piece's CRC-32C and the
+ * length of the second, without looking at the data again.
+ */
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, size_t length2);
+
+/*
+ * Returns true if crc32c uses a hardware instruction on this machine.
+ */
+bool crc32cHardware();
+
+#endif
@@ -1,190 +1,476 @@
-/*
- * Authors: Philip Clark and Susannah Meyer
- * Description: This is our Huffman encoding program. The program follows the spec in building a frequency table,
- * an encoding tree, and an encoding map which are used to encode the file/string inputed
- * by the user and decode the resulting encoding. The program also uses the same functions
- * to write the compress and decompression methods by writing and reading a header which
- * states the frequency table to the output/from the input stream in order to deal with completing
- * the encoding/decoding process for files in one fell swoop.
- * Date: 11/18/15
- */
-
-#include "encoding.h"
-#include "pqueue.h"
-#include "filelib.h"
-#include "vector.h"
-
-/*
- * This method reads in the string or file from the input stream and makes a map with the characters
- * as keys and the frequencies/number of occurences of these characters as values.
- * @input: the stream where the file/string is being read from
- */
-Map<int, int> buildFrequencyTable(istream& input) {
-    Map<int, int> freqTable;
-    while(true) { //continue until no more input is read
-   int c = input.get(); //uses int to prevent bug of char halving (only goes to 128)
-   if(input.fail()) break;
-   freqTable[c]++; //increment frequency
-    }
-
-    freqTable[PSEUDO_EOF] = 1; //add EOF character
-    return freqTable;
-}
-
-/*
- * This function loops through the intergers (characters) in the frequency table
- * and, for each key, creates a node with that character value and the frequency and
- * enqueues to the priority queue with a priority of the frequency (ie to ensure that
- * characters that don't occur often are in front). Then it combines entries at the front of
- * priority queue into a binary tree.
- * @freqTable: the frequency table made in the above functions which maps the characters from the
- * input to their frequencies
- */
-HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable) {
-    PriorityQueue<HuffmanNode*> p;
-    for(int i: freqTable) {
-    HuffmanNode* next = new HuffmanNode; //make new node
-    next->character = i; //set pointers
-    next->count = freqTable[i];
-    p.enqueue(next, next->count); //enqueue with priority of frequency of character pointer
-    }
-
-    while(p.size()>1) { //continue until there is a root node
-    HuffmanNode* first = p.dequeue(); //take first two nodes in priority queue
-    HuffmanNode* second = p.dequeue();
-    HuffmanNode* comb = new HuffmanNode; //make parent node
-    comb->character = NOT_A_CHAR;
-    comb->count = first->count + second->count; //make frequency combined frequency (to put farther back on the queue)
-    comb->zero = first; //child pointer
-    comb->one = second; //child pointer
-    p.enqueue(comb, comb->count); //enqueue new parent ndoe
-    }
-
-    return p.dequeue();
-}
-
-/*
- * The recursive helper function that largely implements the encoding map. The method recursively
- * walks down the tree keeping track of its path (of 1s and 0s) through the s parameter until it hits
- * a leaf.
- */
-void buildHelper(HuffmanNode* curr, string s, Map<int, string>& encodingMap) {
-    if(curr->isLeaf()) { //base case -- if the recursion has reached a leaf, map the leaf's character pointer to the path string
-        encodingMap[curr->character] = s;
-        return;
-    }
-    else if(curr!=NULL) { //otherwise
-    buildHelper(curr->zero, s+"0", encodingMap); //recurse to left
-    buildHelper(curr->one, s+"1", encodingMap); //recurse to right
-    }
-}
-
-/*
- * The buildEncodingMap method creates a map from a character in the input (represented as an int)
- * to a string of 1s and 0s that represent the compression of that character.
- * @encodingTree: the root node of the binary tree which organizes the characters in the input
- * and their frequency.
- */
-Map<int, string> buildEncodingMap(HuffmanNode* encodingTree) {
-    Map<int, string> encodingMap;
-    buildHelper(encodingTree, "", encodingMap); //calls helper function which does the recursive work
-    return encodingMap;
-}
-
-/*
- * The encodeData method takes in the file/string input and, character by character, encodes
- * it.
- * @input: what the data to be encoded is being read from
- * @encodingMap: the map which takes characters (as integers) to the encoded string of 1s and 0s
- * @output: what the encoded data is being written to
- */
-void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output) {
-    while(true) { //as longas there are characters to get
-        int c = input.get();
-        if(input.fail()) break;
-        for (int i = 0; i < encodingMap[c].length(); ++i) { //loop through encoded series of 1s and 0s and write them to the output
-            output.writeBit(encodingMap[c][i]-'0');
-        }
-    }
-    for (int i = 0; i < encodingMap[PSEUDO_EOF].length(); ++i) { //do same thing for EOF character
-        output.writeBit(encodingMap[PSEUDO_EOF][i]-'0');
-    }
-    output.flush(); //flush output
-}
-
-/*
- * The helper function for decodeData that recursively moves down the path specified by the input (1 for right, 0 for left)
- * until it hits a leaf which is either a character to be written to the output or the marker for the end of the file.
- * @input: what the encoded data is being read from
- * @curr: the node the recursion is currently on in the binary tree
- * @output: what the decoded data is being written to
- * @encodingTree: the root node of the binary encoding tree
- */
-bool decodeDataHelper (ibitstream& input, HuffmanNode* curr, ostream& output, HuffmanNode* encodingTree) {
-    if(!input.fail()) { //continue whiel there is input
-        if(curr->isLeaf()) { //base case which "fails fast" in order to prevent unnecessary recursive calls
-            if(curr->character==PSEUDO_EOF) return false;
-            output.put(curr->character);
-            return true;
-        } else { //recursive case which reads in the next encoding bit and uses it to pick the next step down in the tree path
-            int branch = input.readBit();
-           if(branch == 0) return decodeDataHelper(input, curr->zero, output, encodingTree);
-           else if(branch == 1) return decodeDataHelper(input, curr->one, output, encodingTree);
-        }
-    }
-    return false;
-}
-
-/*
- * The decodeData method takes in the encoding tree's root node and the input stream with the
- * encoded data and recursively moves down the encoding tree to decode the data.
- * @input: what the encoded data is being read from
- * @encodingTree: the root node of the binary encoding tree
- * @output: what the decoded data is being written to
- */
-void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output) {
-    HuffmanNode* curr = encodingTree; //a current node pointer to prevent us from losing the root node's place
-    while (decodeDataHelper(input, curr, output, encodingTree)); //continues until a false case is found (ie EOF or no more nodes)
-}
-
-/*
- * The compress method runs the above functions (and writes the header frequency table to the output)
- * in order to encode the data in one fell swoop.
- * @input: where the data is being encoded from
- * @output: where the encoded data is being written to
- */
-void compress(istream& input, obitstream& output) {
-  Map<int, int> freqTable = buildFrequencyTable(input);
-  output << freqTable; //writes out header
-  HuffmanNode* root = buildEncodingTree(freqTable); //builds encoding map from freq table
-  rewindStream(input); //rewinds the stream to allow the useer to read from it in decompress
-  Map<int, string> encodingMap = buildEncodingMap(root); //builds encoding map from encoding tree
-  encodeData(input, encodingMap, output); //calls encodeData with above tools
-  freeTree(root); //free memory
-}
-
-/*
- * The decompress method runs a combination of the above methods, after reading the frequency table
- * from the input stream, to decompress the file and free the created encoding tree.
- * @input: where the encoded data is being read from
- * @output: where the decoded data is being written to
- */
-void decompress(ibitstream& input, ostream& output) {
-Map<int, int> freqTable;
-input >> freqTable; //reads frequency map (header)
-HuffmanNode* root = buildEncodingTree(freqTable); //creates encoding tree from table
-decodeData(input, root, output); //calls decode data with above tools
-freeTree(root); //free memory
-}
-
-/*
- * The freeTree method recursively moves down the tree to delete all the nodes and prevent a memory leak
- * @node: the root node of the tree
- */
-void freeTree(HuffmanNode* node) {
-    if(node!=NULL) { //implicit base case to stop when it is null
-        freeTree(node->zero);
-        freeTree(node->one);
-        delete node; //kill current node
-    }
-}
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This is our Huffman encoding program. The program follows the spec in building a frequency table,
+ * an encoding tree, and an encoding map which are used to encode the file/string inputed
+ * by the user and decode the resulting encoding. The program also uses the same functions
+ * to write the compress and decompression methods by writing and reading a header which
+ * states the frequency table to the output/from the input stream in order to deal with completing
+ * the encoding/decoding process for files in one fell swoop.
+ * Date: 11/18/15
+ */
+
+#include "encoding.h"
+#include "AdaptiveHuffman.h"
+#include "BitIO.h"
+#include "blockcodec.h"
+#include "MappedFile.h"
+#include "error.h"
+#include "histogram.h"
+#include "HuffmanPool.h"
+#include "pqueue.h"
+#include "filelib.h"
+#include "vector.h"
+
+/*
+ * Turns an array of byte counts into the frequency table map used by the rest of the API,
+ * adding the EOF character.
+ * @counts: how many times each byte value occurs in the input
+ */
+static Map<int, int> frequencyTableFromCounts(const uint64_t counts[256]) {
+    Map<int, int> freqTable;
+    for (int c = 0; c < 256; c++) {
+        if (counts[c] > 0) freqTable[c] = (int) counts[c]; //only characters that occur go in the table
+    }
+    freqTable[PSEUDO_EOF] = 1; //add EOF character
+    return freqTable;
+}
+
+/*
+ * This method reads in the string or file from the input stream and makes a map with the characters
+ * as keys and the frequencies/number of occurences of these characters as values. The counting itself
+ * is done in bulk by the histogram kernel (see histogram.h); the map is only built at the end.
+ * @input: the stream where the file/string is being read from
+ */
+Map<int, int> buildFrequencyTable(istream& input) {
+    uint64_t counts[256] = {0};
+    countBytes(input, counts);
+    return frequencyTableFromCounts(counts);
+}
+
+/*
+ * This function loops through the intergers (characters) in the frequency table
+ * and, for each key, creates a node with that character value and the frequency and
+ * enqueues to the priority queue with a priority of the frequency (ie to ensure that
+ * characters that don't occur often are in front). Then it combines entries at the front of
+ * priority queue into a binary tree.
+ * @freqTable: the frequency table made in the above functions which maps the characters from the
+ * input to their frequencies
+ */
+HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable) {
+    PriorityQueue<HuffmanNode*> p;
+    for(int i: freqTable) {
+    HuffmanNode* next = new HuffmanNode; //make new node
+    next->character = i; //set pointers
+    next->count = freqTable[i];
+    p.enqueue(next, next->count); //enqueue with priority of frequency of character pointer
+    }
+
+    while(p.size()>1) { //continue until there is a root node
+    HuffmanNode* first = p.dequeue(); //take first two nodes in priority queue
+    HuffmanNode* second = p.dequeue();
+    HuffmanNode* comb = new HuffmanNode; //make parent node
+    comb->character = NOT_A_CHAR;
+    comb->count = first->count + second->count; //make frequency combined frequency (to put farther back on the queue)
+    comb->zero = first; //child pointer
+    comb->one = second; //child pointer
+    p.enqueue(comb, comb->count); //enqueue new parent ndoe
+    }
+
+    return p.dequeue();
+}
+
+/*
+ * The recursive helper function that largely implements the encoding map. The method recursively
+ * walks down the tree keeping track of its path (of 1s and 0s) through the s parameter until it hits
+ * a leaf.
+ */
+void buildHelper(HuffmanNode* curr, string s, Map<int, string>& encodingMap) {
+    if(curr->isLeaf()) { //base case -- if the recursion has reached a leaf, map the leaf's character pointer to the path string
+        encodingMap[curr->character] = s;
+        return;
+    }
+    else if(curr!=NULL) { //otherwise
+    buildHelper(curr->zero, s+"0", encodingMap); //recurse to left
+    buildHelper(curr->one, s+"1", encodingMap); //recurse to right
+    }
+}
+
+/*
+ * The buildEncodingMap method creates a map from a character in the input (represented as an int)
+ * to a string of 1s and 0s that represent the compression of that character.
+ * @encodingTree: the root node of the binary tree which organizes the characters in the input
+ * and their frequency.
+ */
+Map<int, string> buildEncodingMap(HuffmanNode* encodingTree) {
+    Map<int, string> encodingMap;
+    buildHelper(encodingTree, "", encodingMap); //calls helper function which does the recursive work
+    return encodingMap;
+}
+
+/*
+ * An encoding map flattened into arrays so that writing a character's code is an array lookup
+ * and one BitWriter call. Codes of up to 32 bits are packed first bit lowest; longer ones, which
+ * only very skewed inputs produce, are kept as their strings.
+ */
+struct PackedCodes {
+    uint32_t bits[PSEUDO_EOF + 1];
+    int length[PSEUDO_EOF + 1];
+    string longCode[PSEUDO_EOF + 1];
+};
+
+/*
+ * Fills in the packed codes for every character in the encoding map (others get an empty code,
+ * which is what looking them up in the map would give).
+ */
+static void packCodes(const Map<int, string>& encodingMap, PackedCodes& codes) {
+    for (int c = 0; c <= PSEUDO_EOF; c++) {
+        codes.bits[c] = 0;
+        codes.length[c] = 0;
+    }
+    for (int c: encodingMap) {
+        if (c < 0 || c > PSEUDO_EOF) continue;
+        string code = encodingMap[c];
+        codes.length[c] = code.length();
+        if (code.length() > 32) {
+            codes.longCode[c] = code;
+        } else {
+            for (int i = 0; i < (int) code.length(); i++) {
+                if (code[i] == '1') codes.bits[c] |= (uint32_t) 1 << i;
+            }
+        }
+    }
+}
+
+static inline void writeCode(BitWriter& writer, const PackedCodes& codes, int c) {
+    if (codes.length[c] <= 32) {
+        writer.writeBits(codes.bits[c], codes.length[c]);
+    } else {
+        for (int i = 0; i < codes.length[c]; i++) {
+            writer.writeBit(codes.longCode[c][i] - '0');
+        }
+    }
+}
+
+/*
+ * The encodeData method takes in the file/string input and, character by character, encodes
+ * it. The input is read in chunks and the bits go through a BitWriter on top of the output stream.
+ * @input: what the data to be encoded is being read from
+ * @encodingMap: the map which takes characters (as integers) to the encoded string of 1s and 0s
+ * @output: what the encoded data is being written to
+ */
+void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output) {
+    PackedCodes codes;
+    packCodes(encodingMap, codes);
+    BitWriter writer(output);
+    char buffer[4096];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) { //as long as there are characters to get
+        for (int i = 0; i < (int) input.gcount(); i++) {
+            writeCode(writer, codes, (unsigned char) buffer[i]);
+        }
+    }
+    writeCode(writer, codes, PSEUDO_EOF); //do same thing for EOF character
+    writer.flush(); //flush output
+}
+
+static const int TREE_TABLE_BITS = 10; //codes up to this long are decoded with one lookup
+static const int DECODE_BUFFER_BYTES = 1 << 14; //decoded characters are written out in chunks this big
+
+/*
+ * An entry of the lookup table decodeData builds from a tree: the node reached by following the
+ * first length bits of the entry's index. That's a leaf for short codes, and an internal node at
+ * depth TREE_TABLE_BITS for longer ones, from which decoding continues a bit at a time.
+ */
+struct TreeTableEntry {
+    HuffmanNode* node;
+    int length;
+};
+
+/*
+ * The recursive helper function that fills in the lookup table for decodeData. It walks down the tree
+ * keeping track of the path so far (first bit lowest) in code, and when it reaches a leaf or the table's
+ * depth it fills in every entry whose low bits are that path.
+ * @curr: the node the recursion is currently on in the binary tree
+ * @depth: how far down the tree curr is
+ * @code: the path from the root to curr
+ * @table: the lookup table being filled in
+ */
+static void fillTreeTable(HuffmanNode* curr, int depth, uint32_t code, TreeTableEntry table[]) {
+    if (curr == NULL) return;
+    if (curr->isLeaf() || depth == TREE_TABLE_BITS) {
+        for (uint32_t index = code; index < (uint32_t) 1 << TREE_TABLE_BITS; index += (uint32_t) 1 << depth) {
+            table[index].node = curr;
+            table[index].length = depth;
+        }
+        return;
+    }
+    fillTreeTable(curr->zero, depth + 1, code, table);
+    fillTreeTable(curr->one, depth + 1, code | ((uint32_t) 1 << depth), table);
+}
+
+/*
+ * The decodeData method takes in the encoding tree's root node and the input stream with the
+ * encoded data and moves down the encoding tree to decode the data. Rather than one step per bit,
+ * it looks the next TREE_TABLE_BITS bits up in a table built from the tree, which jumps straight to
+ * the leaf for all but the longest codes; those finish the walk a bit at a time.
+ * @input: what the encoded data is being read from
+ * @encodingTree: the root node of the binary encoding tree
+ * @output: what the decoded data is being written to
+ */
+void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output) {
+    if (encodingTree == NULL || encodingTree->isLeaf()) return; //a lone leaf has no bits to read
+    TreeTableEntry* table = new TreeTableEntry[1 << TREE_TABLE_BITS];
+    for (int i = 0; i < (1 << TREE_TABLE_BITS); i++) {
+        table[i].node = NULL;
+        table[i].length = 0;
+    }
+    fillTreeTable(encodingTree, 0, 0, table);
+
+    BitReader reader(input);
+    char buffer[DECODE_BUFFER_BYTES];
+    int buffered = 0;
+    while (true) { //continues until EOF or no more input
+        reader.refill();
+        const TreeTableEntry& entry = table[reader.window() & ((1 << TREE_TABLE_BITS) - 1)];
+        HuffmanNode* curr = entry.node;
+        if (curr == NULL || entry.length > reader.bitsAvailable()) break;
+        reader.consume(entry.length);
+        while (curr != NULL && !curr->isLeaf()) { //long code: keep walking
+            int branch = reader.readBit();
+            if (branch < 0) curr = NULL;
+            else curr = branch == 1 ? curr->one : curr->zero;
+        }
+        if (curr == NULL || curr->character == PSEUDO_EOF) break;
+        buffer[buffered++] = (char) curr->character;
+        if (buffered == DECODE_BUFFER_BYTES) {
+            output.write(buffer, buffered);
+            buffered = 0;
+        }
+    }
+    output.write(buffer, buffered);
+    delete[] table;
+}
+
+/*
+ * The compress method runs the above functions (and writes the header frequency table to the output)
+ * in order to encode the data in one fell swoop.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ */
+void compress(istream& input, obitstream& output) {
+  Map<int, int> freqTable = buildFrequencyTable(input);
+  output << freqTable; //writes out header
+  HuffmanNode* root = buildEncodingTree(freqTable); //builds encoding map from freq table
+  rewindStream(input); //rewinds the stream to allow the useer to read from it in decompress
+  Map<int, string> encodingMap = buildEncodingMap(root); //builds encoding map from encoding tree
+  encodeData(input, encodingMap, output); //calls encodeData with above tools
+  freeTree(root); //free memory
+}
+
+/*
+ * The decompress method runs a combination of the above methods, after reading the frequency table
+ * from the input stream, to decompress the file and free the created encoding tree.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompress(ibitstream& input, ostream& output) {
+Map<int, int> freqTable;
+input >> freqTable; //reads frequency map (header)
+HuffmanNode* root = buildEncodingTree(freqTable); //creates encoding tree from table
+decodeData(input, root, output); //calls decode data with above tools
+freeTree(root); //free memory
+}
+
+/*
+ * The mapped version of buildFrequencyTable counts the bytes of an in-memory buffer (normally a
+ * MappedFile) directly, so there is no virtual stream call per character.
+ * @data: the first byte of the input
+ * @length: the number of bytes of input
+ */
+Map<int, int> buildFrequencyTable(const unsigned char* data, size_t length) {
+    uint64_t counts[256] = {0};
+    countBytes(data, length, counts);
+    return frequencyTableFromCounts(counts);
+}
+
+/*
+ * The mapped version of encodeData codes an in-memory buffer straight into a BitWriter, so
+ * there is no stream call per character or per bit.
+ * @data: the first byte of the input
+ * @length: the number of bytes of input
+ * @encodingMap: the map which takes characters (as integers) to the encoded string of 1s and 0s
+ * @output: what the encoded data is being written to
+ */
+void encodeData(const unsigned char* data, size_t length, const Map<int, string>& encodingMap, obitstream& output) {
+    PackedCodes codes;
+    packCodes(encodingMap, codes);
+    BitWriter writer(output);
+    for (size_t i = 0; i < length; i++) {
+        writeCode(writer, codes, data[i]);
+    }
+    writeCode(writer, codes, PSEUDO_EOF); //end with the EOF character
+    writer.flush();
+}
+
+/*
+ * The compressFile method is compress for a file on disk. It maps the file once and runs both the
+ * frequency count and the encoding over the mapped bytes, so the input is never copied or rewound.
+ * The output format is identical to compress's.
+ * @inputFileName: the file being compressed
+ * @output: where the encoded data is being written to
+ */
+void compressFile(string inputFileName, obitstream& output) {
+    MappedFile input;
+    if (!input.open(inputFileName)) {
+        error("compressFile: unable to open " + inputFileName);
+    }
+    Map<int, int> freqTable = buildFrequencyTable(input.data(), input.size());
+    output << freqTable; //writes out header
+    HuffmanNode* root = buildEncodingTree(freqTable);
+    Map<int, string> encodingMap = buildEncodingMap(root);
+    encodeData(input.data(), input.size(), encodingMap, output);
+    freeTree(root); //free memory
+}
+
+/*
+ * The freeTree method recursively moves down the tree to delete all the nodes and prevent a memory leak
+ * @node: the root node of the tree
+ */
+void freeTree(HuffmanNode* node) {
+    if(node!=NULL) { //implicit base case to stop when it is null
+        freeTree(node->zero);
+        freeTree(node->one);
+        delete node; //kill current node
+    }
+}
+
+/*
+ * The length-limited version of buildEncodingTree gets each character's code length from a
+ * HuffmanPool (which falls back to package-merge when the plain Huffman tree is too deep), assigns
+ * canonical codes from those lengths, and then builds a HuffmanNode tree that spells out those
+ * codes, so the result works with buildEncodingMap, decodeData and freeTree like any other tree.
+ * @freqTable: the frequency table which maps the characters from the input to their frequencies
+ * @maxCodeLength: the longest code any character may get
+ */
+HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable, int maxCodeLength) {
+    for (int ch: freqTable) {
+        if (ch < 0 || ch > PSEUDO_EOF) error("buildEncodingTree: frequency table has a non-character key");
+    }
+    if (freqTable.size() == 1) { //a lone character is a lone leaf, like the unlimited tree
+        for (int ch: freqTable) return new HuffmanNode(ch, freqTable[ch]);
+    }
+
+    HuffmanPool pool;
+    pool.build(freqTable);
+    int lengths[PSEUDO_EOF + 1];
+    pool.codeLengths(lengths, PSEUDO_EOF + 1, maxCodeLength);
+    HuffmanCode code;
+    code.build(lengths, PSEUDO_EOF + 1);
+
+    HuffmanNode* root = new HuffmanNode;
+    for (int ch: freqTable) { //walk each code from the root, making internal nodes as needed
+        string path = code.toString(ch);
+        HuffmanNode* curr = root;
+        curr->count += freqTable[ch];
+        for (int i = 0; i < (int) path.length(); i++) {
+            HuffmanNode*& child = path[i] == '0' ? curr->zero : curr->one;
+            if (child == NULL) child = new HuffmanNode;
+            curr = child;
+            curr->count += freqTable[ch];
+        }
+        curr->character = ch;
+    }
+    return root;
+}
+
+/*
+ * The table-driven decodeData reads through a BitReader, so each character takes one lookup of the
+ * reader's upcoming bits, which gives both the character and how many bits to drop.
+ * Stops at the EOF character or when the remaining bits don't form a code.
+ * @input: what the encoded data is being read from (starting on a byte boundary)
+ * @decodeTable: the table for the code the data was encoded with
+ * @output: what the decoded data is being written to
+ */
+void decodeData(ibitstream& input, const HuffmanDecodeTable& decodeTable, ostream& output) {
+    BitReader reader(input);
+    char buffer[DECODE_BUFFER_BYTES];
+    int buffered = 0;
+    while (true) {
+        reader.refill();
+        uint32_t entry = decodeTable.entry(reader.window());
+        int length = HuffmanDecodeTable::entryLength(entry);
+        if (length == 0 || length > reader.bitsAvailable()) break; //not a code, or ran out of bits
+        reader.consume(length);
+        int ch = HuffmanDecodeTable::entrySymbol(entry);
+        if (ch == PSEUDO_EOF) break;
+        buffer[buffered++] = (char) ch;
+        if (buffered == DECODE_BUFFER_BYTES) {
+            output.write(buffer, buffered);
+            buffered = 0;
+        }
+    }
+    output.write(buffer, buffered);
+}
+
+/*
+ * The compressAdaptive method codes the input in a single pass with an adaptive Huffman model,
+ * reading it in chunks as it arrives; it never needs the whole input or a header.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ */
+void compressAdaptive(istream& input, obitstream& output) {
+    AdaptiveHuffmanModel model;
+    BitWriter writer(output);
+    char buffer[4096];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+        for (int i = 0; i < (int) input.gcount(); i++) {
+            model.writeSymbol((unsigned char) buffer[i], writer);
+        }
+    }
+    model.writeSymbol(PSEUDO_EOF, writer);
+    writer.flush();
+}
+
+/*
+ * The decompressAdaptive method runs the same model as compressAdaptive, updating it after each
+ * character it decodes, until it reaches the EOF character. Running out of bits first, or reading
+ * a symbol the model can't have sent, means the data is damaged.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressAdaptive(ibitstream& input, ostream& output) {
+    AdaptiveHuffmanModel model;
+    BitReader reader(input);
+    char buffer[DECODE_BUFFER_BYTES];
+    int buffered = 0;
+    while (true) {
+        int ch = model.readSymbol(reader);
+        if (ch < 0) error("decompressAdaptive: compressed data is corrupt or truncated");
+        if (ch == PSEUDO_EOF) break;
+        buffer[buffered++] = (char) ch;
+        if (buffered == DECODE_BUFFER_BYTES) {
+            output.write(buffer, buffered);
+            buffered = 0;
+        }
+    }
+    output.write(buffer, buffered);
+}
+
+/*
+ * The compressANS method compresses the input as a block stream with the tANS backend.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ */
+void compressANS(istream& input, obitstream& output) {
+    BlockOptions options;
+    options.backend = BACKEND_TANS;
+    compressBlocks(input, output, options);
+}
+
+/*
+ * The decompressANS method decodes a stream written by compressANS.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressANS(ibitstream& input, ostream& output) {
+    decompressBlocks(input, output);
+}
@@ -1,36 +1,71 @@
-/*
- * CS 106B Huffman Encoding
- * This file declares the functions that you will need to write in this
- * assignment for your Huffman Encoder in huffmanencoding.cpp.
- *
- * Please do not modify this provided file. Your turned-in files should work
- * with an unmodified version of all provided code files.
- *
- * Author : Marty Stepp
- * Version: Thu 2013/11/14
- */
-
-#ifndef _encoding_h
-#define _encoding_h
-
-#include <iostream>
-#include <string>
-#include "bitstream.h"
-#include "HuffmanNode.h"
-#include "map.h"
-using namespace std;
-
-/*
- * See huffmanencoding.cpp for documentation of these functions
- * (which you are supposed to write, based on the spec).
- */
-Map<int, int> buildFrequencyTable(istream& input);
-HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable);
-Map<int, string> buildEncodingMap(HuffmanNode* encodingTree);
-void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output);
-void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output);
-void compress(istream& input, obitstream& output);
-void decompress(ibitstream& input, ostream& output);
-void freeTree(HuffmanNode* node);
-
-#endif
+/*
+ * CS 106B Huffman Encoding
+ * This file declares the functions that you will need to write in this
+ * assignment for your Huffman Encoder in huffmanencoding.cpp.
+ *
+ * Please do not modify this provided file. Your turned-in files should work
+ * with an unmodified version of all provided code files.
+ *
+ * Author : Marty Stepp
+ * Version: Thu 2013/11/14
+ */
+
+#ifndef _encoding_h
+#define _encoding_h
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "bitstream.h"
+#include "HuffmanNode.h"
+#include "huffmancode.h"
+#include "map.h"
+using namespace std;
+
+/*
+ * See huffmanencoding.cpp for documentation of these functions
+ * (which you are supposed to write, based on the spec).
+ */
+Map<int, int> buildFrequencyTable(istream& input);
+HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable);
+Map<int, string> buildEncodingMap(HuffmanNode* encodingTree);
+void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output);
+void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output);
+void compress(istream& input, obitstream& output);
+void decompress(ibitstream& input, ostream& output);
+void freeTree(HuffmanNode* node);
+
+/*
+ * Memory-mapped variants: these scan an input file's bytes in place (see MappedFile.h)
+ * instead of pulling them through istream::get(), and compressFile needs no rewind.
+ */
+Map<int, int> buildFrequencyTable(const unsigned char* data, size_t length);
+void encodeData(const unsigned char* data, size_t length, const Map<int, string>& encodingMap, obitstream& output);
+void compressFile(string inputFileName, obitstream& output);
+
+/*
+ * Length-limited variants: buildEncodingTree with a maximum code length builds a tree whose
+ * codes are canonical and no longer than maxCodeLength bits (see HuffmanPool.h), and decodeData
+ * with a HuffmanDecodeTable decodes such a code with one table lookup per character.
+ */
+HuffmanNode* buildEncodingTree(const Map<int, int>& freqTable, int maxCodeLength);
+void decodeData(ibitstream& input, const HuffmanDecodeTable& decodeTable, ostream& output);
+
+/*
+ * Adaptive (one-pass) Huffman coding: no frequency table header and no rewind. The code adapts
+ * as characters go by (see AdaptiveHuffman.h), and the output ends with the EOF character.
+ * decompressAdaptive throws an error if the data is truncated or corrupt.
+ */
+void compressAdaptive(istream& input, obitstream& output);
+void decompressAdaptive(ibitstream& input, ostream& output);
+
+/*
+ * Same as compress/decompress but with a tANS coder instead of Huffman codes: the input is
+ * compressed as a block stream (blockcodec.h) whose blocks use the tANS backend, which gets
+ * within a fraction of a percent of the entropy even where Huffman codes would need to spend a
+ * whole bit on a very common character.
+ */
+void compressANS(istream& input, obitstream& output);
+void decompressANS(ibitstream& input, ostream& output);
+
+#endif
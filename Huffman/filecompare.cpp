@@ -0,0 +1,154 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the file comparison tools declared in filecompare.h. The
+ * search for the first difference compares 64 bytes per step with SSE2 (four 16-byte compares
+ * whose results are combined, so the loop has one branch per 64 bytes) and narrows a mismatch
+ * down with 8-byte words; other machines use the word loop throughout. Windows are printed a row
+ * at a time into a small buffer, like printBits.
+ */
+
+#include "filecompare.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const size_t WORD_BYTES = 8;
+
+size_t firstDifference(const unsigned char* a, const unsigned char* b, size_t length) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 64 <= length; i += 64) {
+        __m128i same0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i)),
+                                       _mm_loadu_si128((const __m128i*) (b + i)));
+        __m128i same1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i + 16)),
+                                       _mm_loadu_si128((const __m128i*) (b + i + 16)));
+        __m128i same2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i + 32)),
+                                       _mm_loadu_si128((const __m128i*) (b + i + 32)));
+        __m128i same3 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i + 48)),
+                                       _mm_loadu_si128((const __m128i*) (b + i + 48)));
+        __m128i same = _mm_and_si128(_mm_and_si128(same0, same1), _mm_and_si128(same2, same3));
+        if (_mm_movemask_epi8(same) != 0xffff) break; //the word loop below finds the byte
+    }
+#endif
+    for (; i + WORD_BYTES <= length; i += WORD_BYTES) {
+        uint64_t wordA;
+        uint64_t wordB;
+        memcpy(&wordA, a + i, WORD_BYTES);
+        memcpy(&wordB, b + i, WORD_BYTES);
+        if (wordA != wordB) break;
+    }
+    for (; i < length; i++) {
+        if (a[i] != b[i]) return i;
+    }
+    return length;
+}
+
+/*
+ * Searches the bytes the files have in common; if those all match, the files differ only where
+ * the shorter one ends.
+ */
+FileDifference compareFiles(const MappedFile& file1, const MappedFile& file2) {
+    FileDifference difference;
+    difference.size1 = file1.size();
+    difference.size2 = file2.size();
+    size_t common = min(file1.size(), file2.size());
+    difference.offset = common == 0 ? 0 : firstDifference(file1.data(), file2.data(), common);
+    difference.identical = difference.offset == common && difference.size1 == difference.size2;
+    return difference;
+}
+
+/*
+ * Returns where a window of windowBytes around offset starts: half of it before offset, rounded
+ * down to the start of a row.
+ */
+static size_t windowStart(size_t offset, size_t windowBytes) {
+    size_t before = windowBytes / 2;
+    size_t start = offset > before ? offset - before : 0;
+    return start - start % VIEW_ROW_BYTES;
+}
+
+/*
+ * Appends the byte's 8 bits to line, lowest bit first (the order printBits uses).
+ */
+static int formatBits(char* line, unsigned char byte) {
+    for (int bit = 0; bit < 8; bit++) {
+        line[bit] = ((byte >> bit) & 1) ? '1' : '0';
+    }
+    return 8;
+}
+
+void printBitsWindow(ostream& out, const unsigned char* data, size_t length, size_t offset, size_t windowBytes) {
+    char line[32 + VIEW_ROW_BYTES * 9 + 1];
+    size_t end = min(length, windowStart(offset, windowBytes) + max(windowBytes, VIEW_ROW_BYTES));
+    for (size_t row = windowStart(offset, windowBytes); row < end; row += VIEW_ROW_BYTES) {
+        int pos = snprintf(line, 32, "%12llu: ", (unsigned long long) row);
+        for (size_t i = row; i < row + VIEW_ROW_BYTES && i < end; i++) {
+            pos += formatBits(line + pos, data[i]);
+            line[pos++] = ' ';
+        }
+        out.write(line, pos);
+        out << endl;
+    }
+}
+
+/*
+ * Writes one file's part of a row: the bytes in hex, then as characters ('.' for unprintable
+ * ones), padded where the file has ended.
+ */
+static int formatRow(char* line, const unsigned char* data, size_t size, size_t row) {
+    int pos = 0;
+    for (size_t i = row; i < row + VIEW_ROW_BYTES; i++) {
+        if (i < size) {
+            pos += snprintf(line + pos, 4, "%02x ", data[i]);
+        } else {
+            memcpy(line + pos, "   ", 3);
+            pos += 3;
+        }
+    }
+    line[pos++] = '|';
+    for (size_t i = row; i < row + VIEW_ROW_BYTES; i++) {
+        line[pos++] = i >= size ? ' ' : isprint(data[i]) ? (char) data[i] : '.';
+    }
+    line[pos++] = '|';
+    return pos;
+}
+
+void printDifferenceWindow(ostream& out, const unsigned char* data1, size_t size1, const unsigned char* data2,
+                           size_t size2, size_t offset, size_t windowBytes) {
+    char line[256];
+    size_t end = min(max(size1, size2), windowStart(offset, windowBytes) + max(windowBytes, VIEW_ROW_BYTES));
+    for (size_t row = windowStart(offset, windowBytes); row < end; row += VIEW_ROW_BYTES) {
+        int pos = snprintf(line, 32, "%12llu: ", (unsigned long long) row);
+        pos += formatRow(line + pos, data1, size1, row);
+        line[pos++] = ' ';
+        line[pos++] = ' ';
+        pos += formatRow(line + pos, data2, size2, row);
+        size_t rowEnd = row + VIEW_ROW_BYTES;
+        bool differs = min(rowEnd, size1) != min(rowEnd, size2);
+        for (size_t i = row; !differs && i < rowEnd && i < size1; i++) {
+            differs = data1[i] != data2[i];
+        }
+        if (differs) {
+            memcpy(line + pos, "  *", 3);
+            pos += 3;
+        }
+        out.write(line, pos);
+        out << endl;
+    }
+    for (int f = 0; f < 2; f++) {
+        const unsigned char* data = f == 0 ? data1 : data2;
+        size_t size = f == 0 ? size1 : size2;
+        out << "bits at " << offset << " in file " << (f + 1) << ": ";
+        if (offset < size) {
+            int pos = formatBits(line, data[offset]);
+            out.write(line, pos);
+            out << endl;
+        } else {
+            out << "(past the end)" << endl;
+        }
+    }
+}
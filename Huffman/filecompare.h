@@ -0,0 +1,58 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the filecompare.h file which declares the tools behind the side-by-side comparison and
+ * the binary file viewer for files of any size. Files are memory-mapped (see MappedFile.h) rather
+ * than read into strings, the first difference is found by comparing many bytes per instruction,
+ * and only a window of rows around the place of interest is printed, so checking that a
+ * multi-gigabyte file round-tripped costs about as much as reading it once.
+ */
+
+#ifndef _filecompare_h
+#define _filecompare_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include "MappedFile.h"
+using namespace std;
+
+const size_t VIEW_ROW_BYTES = 8;         // bytes per printed row, as in printBits
+const size_t VIEW_WINDOW_BYTES = 128;    // bytes printed around a position of interest
+const size_t VIEW_ALL_MAX_BYTES = 4096;  // files up to this size are shown whole
+
+/*
+ * Returns the offset of the first byte at which a and b differ, or length if the first length
+ * bytes of both are the same.
+ */
+size_t firstDifference(const unsigned char* a, const unsigned char* b, size_t length);
+
+/*
+ * The result of compareFiles.
+ */
+struct FileDifference {
+    bool identical;   // same size and same bytes
+    uint64_t offset;  // first byte that differs (or where the shorter file ends); the size if identical
+    uint64_t size1;
+    uint64_t size2;
+};
+
+/*
+ * Compares two mapped files.
+ */
+FileDifference compareFiles(const MappedFile& file1, const MappedFile& file2);
+
+/*
+ * Prints the rows of data around offset (about windowBytes of them) in printBits' format, each
+ * row labeled with the offset of its first byte.
+ */
+void printBitsWindow(ostream& out, const unsigned char* data, size_t length, size_t offset,
+                     size_t windowBytes = VIEW_WINDOW_BYTES);
+
+/*
+ * Prints the rows of two files around offset side by side, in hex and as characters, marking
+ * rows where they differ, then the bits of the byte at offset in each.
+ */
+void printDifferenceWindow(ostream& out, const unsigned char* data1, size_t size1, const unsigned char* data2,
+                           size_t size2, size_t offset, size_t windowBytes = VIEW_WINDOW_BYTES);
+
+#endif
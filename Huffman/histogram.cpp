@@ -0,0 +1,93 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the byte histogram kernel. Incrementing a single count
+ * array stalls whenever two nearby bytes are equal (the second increment has to wait for the
+ * first one's store), which is exactly the common case for text. So the kernel spreads
+ * consecutive bytes across four interleaved 256-entry arrays, reads eight bytes per load,
+ * and only sums the arrays at the end.
+ */
+
+#include "histogram.h"
+#include <cstring>
+
+static const size_t LANE_FLUSH_BYTES = (size_t) 1 << 30; //keeps each 32-bit lane count from overflowing
+static const size_t READ_CHUNK_BYTES = 1 << 16; //how much of a stream is counted at a time
+
+/*
+ * Counts one piece of input (no more than LANE_FLUSH_BYTES) into the four lane arrays.
+ * Big-Oh: O(N)
+ */
+static void countLanes(const unsigned char* data, size_t length, uint32_t lanes[4][256]) {
+    const unsigned char* p = data;
+    const unsigned char* end = data + length;
+    while (end - p >= 16) { //unrolled: two 8-byte loads, sixteen increments spread over four lanes
+        uint64_t a, b;
+        memcpy(&a, p, 8);
+        memcpy(&b, p + 8, 8);
+        lanes[0][a & 0xff]++;
+        lanes[1][(a >> 8) & 0xff]++;
+        lanes[2][(a >> 16) & 0xff]++;
+        lanes[3][(a >> 24) & 0xff]++;
+        lanes[0][(a >> 32) & 0xff]++;
+        lanes[1][(a >> 40) & 0xff]++;
+        lanes[2][(a >> 48) & 0xff]++;
+        lanes[3][a >> 56]++;
+        lanes[0][b & 0xff]++;
+        lanes[1][(b >> 8) & 0xff]++;
+        lanes[2][(b >> 16) & 0xff]++;
+        lanes[3][(b >> 24) & 0xff]++;
+        lanes[0][(b >> 32) & 0xff]++;
+        lanes[1][(b >> 40) & 0xff]++;
+        lanes[2][(b >> 48) & 0xff]++;
+        lanes[3][b >> 56]++;
+        p += 16;
+    }
+    while (p < end) { //leftover bytes
+        lanes[0][*p++]++;
+    }
+}
+
+/*
+ * Counts the range in pieces small enough that the 32-bit lanes can't overflow, folding the
+ * lanes into the caller's 64-bit counts after each piece.
+ * Big-Oh: O(N)
+ */
+void countBytes(const unsigned char* data, size_t length, uint64_t counts[256]) {
+    while (length > 0) {
+        size_t piece = length < LANE_FLUSH_BYTES ? length : LANE_FLUSH_BYTES;
+        uint32_t lanes[4][256];
+        memset(lanes, 0, sizeof(lanes));
+        countLanes(data, piece, lanes);
+        for (int c = 0; c < 256; c++) {
+            counts[c] += (uint64_t) lanes[0][c] + lanes[1][c] + lanes[2][c] + lanes[3][c];
+        }
+        data += piece;
+        length -= piece;
+    }
+}
+
+/*
+ * One increment per byte. The lane trick above would need four 256 KB tables here, more than it
+ * would save, since only runs of one byte hit the same counter twice in a row. The caller keeps
+ * length below 2^32.
+ * Big-Oh: O(N)
+ */
+void countPairs(const unsigned char* data, size_t length, uint32_t counts[256][256]) {
+    unsigned char previous = 0;
+    for (size_t i = 0; i < length; i++) {
+        counts[previous][data[i]]++;
+        previous = data[i];
+    }
+}
+
+/*
+ * Reads the stream a chunk at a time with istream::read and counts each chunk.
+ * Like a get() loop, this leaves the stream in the fail state at the end of the input.
+ */
+void countBytes(istream& input, uint64_t counts[256]) {
+    char* buffer = new char[READ_CHUNK_BYTES];
+    while (input.read(buffer, READ_CHUNK_BYTES) || input.gcount() > 0) {
+        countBytes((const unsigned char*) buffer, (size_t) input.gcount(), counts);
+    }
+    delete[] buffer;
+}
@@ -0,0 +1,33 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the histogram.h file which declares the byte-counting kernel behind buildFrequencyTable.
+ * Counting happens in plain arrays; conversion to a Map<int, int> only happens at the
+ * encoding.h API boundary.
+ */
+
+#ifndef _histogram_h
+#define _histogram_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+using namespace std;
+
+/*
+ * Adds the number of occurrences of each byte value in the given range to counts
+ * (which the caller zeroes before the first call, so a stream can be counted in pieces).
+ */
+void countBytes(const unsigned char* data, size_t length, uint64_t counts[256]);
+
+/*
+ * Adds the number of times each byte follows each other byte to counts[previous][ch]. The byte
+ * before data is taken to be 0, so every byte of the range is counted exactly once.
+ */
+void countPairs(const unsigned char* data, size_t length, uint32_t counts[256][256]);
+
+/*
+ * Counts every remaining byte of the given stream into counts, reading it in large chunks.
+ */
+void countBytes(istream& input, uint64_t counts[256]);
+
+#endif
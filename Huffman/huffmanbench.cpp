@@ -0,0 +1,579 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the compression benchmark declared in huffmanbench.h. Each
+ * input is run through every codec; the original Huffman functions are timed stage by stage
+ * (histogram, tree build, map build, header, encode, decode, each on the previous stages' results)
+ * and the other codecs as whole compress and decompress calls. Every run is checked to round-trip exactly.
+ */
+
+#include "huffmanbench.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "LZW.h"
+#include "MappedFile.h"
+#include "blockcodec.h"
+#include "bwt.h"
+#include "encoding.h"
+#include "filelib.h"
+#include "lz77.h"
+#include "memorycodec.h"
+#include "strlib.h"
+#include "wordcoding.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static const int MAX_RUNS = 1000; //cap on repeats of one stage
+
+/*
+ * A codec the benchmark can run: functions that compress/decompress between two strings.
+ */
+struct BenchmarkCodec {
+    string name;
+    void (*compressFunction)(const string& input, string& output);
+    void (*decompressFunction)(const string& input, string& output);
+};
+
+static void compressAdaptiveString(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressAdaptive(in, out);
+    output = out.str();
+}
+
+static void decompressAdaptiveString(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressAdaptive(in, out);
+    output = out.str();
+}
+
+static void compressLZWString(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressLZW(in, out);
+    output = out.str();
+}
+
+static void decompressLZWString(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressLZW(in, out);
+    output = out.str();
+}
+
+static void compressLZ77String(const string& input, string& output, int level) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressLZ77(in, out, level);
+    output = out.str();
+}
+
+static void compressLZ77FastString(const string& input, string& output) {
+    compressLZ77String(input, output, LZ77_MIN_LEVEL);
+}
+
+static void compressLZ77DefaultString(const string& input, string& output) {
+    compressLZ77String(input, output, LZ77_DEFAULT_LEVEL);
+}
+
+static void compressLZ77BestString(const string& input, string& output) {
+    compressLZ77String(input, output, LZ77_MAX_LEVEL);
+}
+
+static void decompressLZ77String(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressLZ77(in, out);
+    output = out.str();
+}
+
+static void compressBWTString(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressBWT(in, out);
+    output = out.str();
+}
+
+static void decompressBWTString(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressBWT(in, out);
+    output = out.str();
+}
+
+static void compressBlocksString(const string& input, string& output, bool interleaved) {
+    istringstream in(input);
+    ostringbitstream out;
+    BlockOptions options;
+    options.interleaved = interleaved;
+    compressBlocks(in, out, options);
+    output = out.str();
+}
+
+static void compressBlocksX1String(const string& input, string& output) {
+    compressBlocksString(input, output, false);
+}
+
+static void compressBlocksX4String(const string& input, string& output) {
+    compressBlocksString(input, output, true);
+}
+
+static void compressOrder1String(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    BlockOptions options;
+    options.backend = BACKEND_ORDER1;
+    compressBlocks(in, out, options);
+    output = out.str();
+}
+
+static void compressANSString(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressANS(in, out);
+    output = out.str();
+}
+
+static void compressSpanString(const string& input, string& output) {
+    OutputBuffer out;
+    compress((const unsigned char*) input.data(), input.size(), out);
+    output.assign((const char*) out.data(), out.size());
+}
+
+static void decompressSpanString(const string& input, string& output) {
+    output.resize((size_t) decompressedSize((const unsigned char*) input.data(), input.size()));
+    OutputBuffer out((unsigned char*) &output[0], output.size());
+    decompress((const unsigned char*) input.data(), input.size(), out);
+}
+
+static void compressWordsString(const string& input, string& output) {
+    istringstream in(input);
+    ostringbitstream out;
+    compressWords(in, out);
+    output = out.str();
+}
+
+static void decompressWordsString(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressWords(in, out);
+    output = out.str();
+}
+
+static void decompressBlocksString(const string& input, string& output) {
+    istringbitstream in(input);
+    ostringstream out;
+    decompressBlocks(in, out);
+    output = out.str();
+}
+
+/*
+ * Every codec except the staged "huffman" one, which is handled separately.
+ */
+static const BenchmarkCodec CODECS[] = {
+    {"huffman-adaptive", compressAdaptiveString, decompressAdaptiveString},
+    {"block-x1", compressBlocksX1String, decompressBlocksString},
+    {"block-x4", compressBlocksX4String, decompressBlocksString},
+    {"block-tans", compressANSString, decompressBlocksString},
+    {"block-order1", compressOrder1String, decompressBlocksString},
+    {"block-span", compressSpanString, decompressSpanString},
+    {"lzw", compressLZWString, decompressLZWString},
+    {"lz77-1", compressLZ77FastString, decompressLZ77String},
+    {"lz77-6", compressLZ77DefaultString, decompressLZ77String},
+    {"lz77-9", compressLZ77BestString, decompressLZ77String},
+    {"bwt", compressBWTString, decompressBWTString},
+    {"words", compressWordsString, decompressWordsString},
+};
+static const int NUM_CODECS = sizeof(CODECS) / sizeof(CODECS[0]);
+static const string STAGED_CODEC = "huffman";
+
+BenchmarkOptions::BenchmarkOptions() {
+    minSize = 4 << 10;
+    maxSize = 16 << 20;
+    minSeconds = 0.2;
+}
+
+Vector<string> benchmarkCodecNames() {
+    Vector<string> names;
+    names.add(STAGED_CODEC);
+    for (int i = 0; i < NUM_CODECS; i++) {
+        names.add(CODECS[i].name);
+    }
+    return names;
+}
+
+static double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Runs stage until it has taken at least minSeconds in total and returns the time per run.
+ */
+template <typename Stage>
+static double timeStage(Stage stage, double minSeconds) {
+    double start = now();
+    double elapsed = 0;
+    int runs = 0;
+    do {
+        stage();
+        runs++;
+        elapsed = now() - start;
+    } while (elapsed < minSeconds && runs < MAX_RUNS);
+    return elapsed / runs;
+}
+
+/*
+ * Returns the peak resident size of this process. Run inside a measurement's own process (see
+ * runMeasurement), that is the measurement's peak.
+ */
+static long peakMemoryKB() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss; //kilobytes on Linux
+#endif
+    return 0;
+}
+
+/*
+ * Writes one CSV row. An empty ratio is left blank.
+ */
+static void writeRow(ostream& out, const string& input, const string& kind, size_t bytes, const string& codec,
+                     const string& stage, double seconds, double ratio) {
+    out << input << "," << kind << "," << bytes << "," << codec << "," << stage << ","
+        << seconds << "," << (seconds > 0 ? bytes / seconds / 1e6 : 0) << ",";
+    if (ratio >= 0) out << ratio;
+    out << "," << peakMemoryKB() << endl;
+}
+
+/*
+ * Small deterministic random number generator (xorshift) so every run sees the same corpus.
+ */
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/*
+ * English-like text: words drawn with a skewed (roughly Zipf) distribution, with punctuation and line breaks.
+ */
+static string generateText(size_t size) {
+    static const char* WORDS[] = {
+        "the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "was", "with", "be", "by",
+        "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an", "had",
+        "they", "you", "were", "their", "one", "all", "we", "can", "her", "has", "there", "been", "if",
+        "more", "when", "will", "would", "who", "so", "no", "compression", "Huffman", "encoding", "tree",
+        "frequency", "stream", "block", "decoder", "throughput", "benchmark", "Stanford", "file"
+    };
+    static const int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+    string text;
+    text.reserve(size + 16);
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    int lineLength = 0;
+    while (text.size() < size) {
+        uint64_t r = nextRandom(state);
+        int word = (int) ((r % NUM_WORDS) * (r % NUM_WORDS) / NUM_WORDS); //squaring skews toward common words
+        text += WORDS[word];
+        lineLength += 1 + strlen(WORDS[word]);
+        int punctuation = (int) ((r >> 32) % 20);
+        if (punctuation == 0) text += ".";
+        else if (punctuation == 1) text += ",";
+        if (lineLength > 70) {
+            text += "\n";
+            lineLength = 0;
+        } else {
+            text += " ";
+        }
+    }
+    text.resize(size);
+    return text;
+}
+
+/*
+ * Binary telemetry-like records: a counter, a timestamp, small sensor readings and flags, little-endian.
+ */
+static string generateBinary(size_t size) {
+    string data;
+    data.reserve(size + 32);
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    uint32_t timestamp = 1447800000;
+    for (uint32_t id = 0; data.size() < size; id++) {
+        uint64_t r = nextRandom(state);
+        timestamp += 1 + (uint32_t) (r % 3);
+        uint32_t fields[4] = {id, timestamp, (uint32_t) (1000 + (r >> 8) % 64), (uint32_t) ((r >> 20) % 4)};
+        for (int f = 0; f < 4; f++) {
+            for (int b = 0; b < 4; b++) {
+                data += (char) ((fields[f] >> (8 * b)) & 0xff);
+            }
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+/*
+ * Uniformly random bytes, standing in for already-compressed data (JPEGs, zips, ...).
+ */
+static string generateRandom(size_t size) {
+    string data(size, '\0');
+    uint64_t state = 0x853c49e6748fea9bULL;
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (char) (nextRandom(state) >> 56);
+    }
+    return data;
+}
+
+/*
+ * Highly skewed bytes: each byte value is half as likely as the one before, which makes the plain
+ * Huffman tree about as deep as it can get.
+ */
+static string generateSkewed(size_t size) {
+    string data(size, '\0');
+    uint64_t state = 0xda3e39cb94b95bdbULL;
+    for (size_t i = 0; i < size; i++) {
+        uint64_t r = nextRandom(state);
+        int zeros = 0;
+        while (zeros < 40 && ((r >> zeros) & 1) == 0) zeros++; //geometric: P(k) = 2^-(k+1)
+        data[i] = (char) ('a' + zeros);
+    }
+    return data;
+}
+
+/*
+ * Runs the original Huffman functions one stage at a time, reporting each stage and the totals.
+ */
+static bool benchmarkStaged(ostream& out, const string& name, const string& kind, const string& input,
+                            const BenchmarkOptions& options) {
+    const unsigned char* data = (const unsigned char*) input.data();
+    size_t size = input.size();
+    Map<int, int> freqTable;
+    HuffmanNode* tree = NULL;
+    Map<int, string> encodingMap;
+    string header;
+    string body;
+    string decoded;
+    string roundTrip;
+
+    double histogram = timeStage([&]() { freqTable = buildFrequencyTable(data, size); }, options.minSeconds);
+    double build = timeStage([&]() { freeTree(tree); tree = buildEncodingTree(freqTable); }, options.minSeconds);
+    double map = timeStage([&]() { encodingMap = buildEncodingMap(tree); }, options.minSeconds);
+    double headerTime = timeStage([&]() {
+        ostringbitstream output;
+        output << freqTable;
+        header = output.str();
+    }, options.minSeconds);
+    double encode = timeStage([&]() { //just the codes: the header is written above
+        ostringbitstream output;
+        encodeData(data, size, encodingMap, output);
+        body = output.str();
+    }, options.minSeconds);
+    istringbitstream codes(body);
+    double decode = timeStage([&]() { //just the codes, with the tree built above
+        codes.clear();
+        codes.seekg(0);
+        ostringstream output;
+        decodeData(codes, tree, output);
+        decoded = output.str();
+    }, options.minSeconds);
+    string compressed = header + body;
+    double decompressTime = timeStage([&]() { //reads the header and rebuilds the tree too
+        istringbitstream input(compressed);
+        ostringstream output;
+        decompress(input, output);
+        roundTrip = output.str();
+    }, options.minSeconds);
+    freeTree(tree);
+
+    double ratio = size > 0 ? (double) compressed.size() / size : 0;
+    writeRow(out, name, kind, size, STAGED_CODEC, "histogram", histogram, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "tree", build, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "map", map, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "header", headerTime, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "encode", encode, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "compress", histogram + build + map + headerTime + encode, ratio);
+    writeRow(out, name, kind, size, STAGED_CODEC, "decode", decode, -1);
+    writeRow(out, name, kind, size, STAGED_CODEC, "decompress", decompressTime, -1);
+    return decoded == input && roundTrip == input;
+}
+
+/*
+ * Runs one codec's compress and decompress on an input and reports both.
+ */
+static bool benchmarkCodec(ostream& out, const BenchmarkCodec& codec, const string& name, const string& kind,
+                           const string& input, const BenchmarkOptions& options) {
+    string compressed;
+    string decoded;
+    double compressTime = timeStage([&]() { codec.compressFunction(input, compressed); }, options.minSeconds);
+    double decompressTime = timeStage([&]() { codec.decompressFunction(compressed, decoded); }, options.minSeconds);
+    double ratio = input.size() > 0 ? (double) compressed.size() / input.size() : 0;
+    writeRow(out, name, kind, input.size(), codec.name, "compress", compressTime, ratio);
+    writeRow(out, name, kind, input.size(), codec.name, "decompress", decompressTime, -1);
+    return decoded == input;
+}
+
+/*
+ * Runs one measurement (a codec on an input), which writes its rows to the stream it is given and
+ * returns whether the codec round-tripped. Where fork is available the measurement runs in a child
+ * process and sends its rows back through a pipe: a process's peak resident size never goes down,
+ * so measured in this process every row after the largest input would show that input's peak.
+ * The child starts with only this process's current memory (about the size of the input), so its
+ * peak tells codecs and sizes apart.
+ */
+template <typename Measure>
+static bool runMeasurement(ostream& out, Measure measure) {
+#ifndef _WIN32
+    int fds[2];
+    pid_t child = -1;
+    if (pipe(fds) == 0) {
+        child = fork();
+        if (child < 0) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+    }
+    if (child == 0) {
+        close(fds[0]);
+        ostringstream rows;
+        string result = measure(rows) ? "1" : "0";
+        result += rows.str();
+        for (size_t written = 0; written < result.size(); ) {
+            ssize_t count = write(fds[1], result.data() + written, result.size() - written);
+            if (count <= 0) _exit(1);
+            written += count;
+        }
+        _exit(0);
+    }
+    if (child > 0) {
+        close(fds[1]);
+        string result;
+        char buffer[4096];
+        ssize_t count;
+        while ((count = read(fds[0], buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, count);
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.empty()) return false; //it crashed
+        out << result.substr(1);
+        return result[0] == '1';
+    }
+#endif
+    return measure(out); //no separate process: the peak is this process's so far
+}
+
+/*
+ * Runs every selected codec over one input.
+ */
+static bool benchmarkInput(ostream& out, const string& name, const string& kind, const string& input,
+                           const BenchmarkOptions& options) {
+    bool ok = true;
+    if (STAGED_CODEC.find(options.codecFilter) != string::npos) {
+        bool roundTripped = runMeasurement(out, [&](ostream& rows) {
+            return benchmarkStaged(rows, name, kind, input, options);
+        });
+        if (!roundTripped) {
+            cerr << "ERROR: " << STAGED_CODEC << " did not round-trip " << name << endl;
+            ok = false;
+        }
+    }
+    for (int i = 0; i < NUM_CODECS; i++) {
+        if (CODECS[i].name.find(options.codecFilter) == string::npos) continue;
+        const BenchmarkCodec& codec = CODECS[i];
+        bool roundTripped = runMeasurement(out, [&](ostream& rows) {
+            return benchmarkCodec(rows, codec, name, kind, input, options);
+        });
+        if (!roundTripped) {
+            cerr << "ERROR: " << CODECS[i].name << " did not round-trip " << name << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*
+ * Generates each kind of input at each size (and reads any corpus files) and benchmarks them.
+ */
+bool runBenchmarks(ostream& out, const BenchmarkOptions& options) {
+    out << "input,kind,bytes,codec,stage,seconds,mb_per_sec,ratio,peak_rss_kb" << endl;
+    bool ok = true;
+    for (size_t size = options.minSize; size > 0 && size <= options.maxSize; size *= 16) {
+        ok &= benchmarkInput(out, "text-" + integerToString(size), "text", generateText(size), options);
+        ok &= benchmarkInput(out, "binary-" + integerToString(size), "binary", generateBinary(size), options);
+        ok &= benchmarkInput(out, "random-" + integerToString(size), "random", generateRandom(size), options);
+        ok &= benchmarkInput(out, "skewed-" + integerToString(size), "skewed", generateSkewed(size), options);
+    }
+    if (options.corpusDir != "") {
+        Vector<string> files;
+        listDirectory(options.corpusDir, files);
+        for (string file: files) {
+            string path = options.corpusDir + "/" + file;
+            if (isDirectory(path)) continue;
+            MappedFile mapped(path);
+            string input((const char*) mapped.data(), mapped.size());
+            ok &= benchmarkInput(out, stringReplace(file, ",", "_"), "file", input, options);
+        }
+    }
+    return ok;
+}
+
+/*
+ * Parses sizes like 4096, 64K, 16M or 1G.
+ */
+static size_t parseSize(string text) {
+    size_t multiplier = 1;
+    char suffix = text.empty() ? '\0' : toupper(text[text.length() - 1]);
+    if (suffix == 'K') multiplier = (size_t) 1 << 10;
+    else if (suffix == 'M') multiplier = (size_t) 1 << 20;
+    else if (suffix == 'G') multiplier = (size_t) 1 << 30;
+    if (multiplier != 1) text = text.substr(0, text.length() - 1);
+    return (size_t) stringToInteger(text) * multiplier;
+}
+
+int benchmarkMain(int argc, char** argv) {
+    BenchmarkOptions options;
+    string outputFile;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--min-size" && hasValue) {
+            options.minSize = parseSize(argv[++i]);
+        } else if (arg == "--max-size" && hasValue) {
+            options.maxSize = parseSize(argv[++i]);
+        } else if (arg == "--corpus" && hasValue) {
+            options.corpusDir = argv[++i];
+        } else if (arg == "--codec" && hasValue) {
+            options.codecFilter = argv[++i];
+        } else if (arg == "--min-seconds" && hasValue) {
+            options.minSeconds = atof(argv[++i]);
+        } else if (arg == "--output" && hasValue) {
+            outputFile = argv[++i];
+        } else {
+            cerr << "usage: " << argv[0] << " [--min-size N] [--max-size N] [--corpus DIR] [--codec NAME]"
+                 << " [--min-seconds S] [--output FILE]" << endl;
+            return 2;
+        }
+    }
+    bool ok;
+    if (outputFile == "") {
+        ok = runBenchmarks(cout, options);
+    } else {
+        ofstream out(outputFile.c_str());
+        ok = runBenchmarks(out, options);
+    }
+    return ok ? 0 : 1;
+}
+
+#ifdef HUFFMAN_BENCHMARK_MAIN
+int main(int argc, char** argv) {
+    return benchmarkMain(argc, argv);
+}
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the huffmanbench.h file which declares the compression benchmark. It runs every codec
+ * over a fixed corpus (generated text, binary records, incompressible and highly skewed data in
+ * sizes from KB up, plus any files the caller points it at) and writes one CSV row per measurement,
+ * so runs can be diffed to catch throughput regressions and to compare codec variants.
+ *
+ * CSV columns: input,kind,bytes,codec,stage,seconds,mb_per_sec,ratio,peak_rss_kb
+ * (ratio is compressed size / original size and is only filled in on "compress" rows. Each codec
+ * runs on each input in a process of its own, so peak_rss_kb is the peak resident size of that
+ * run: the input plus the codec's buffers. Where processes can't be forked it is the benchmark's
+ * peak so far, or 0.)
+ */
+
+#ifndef _huffmanbench_h
+#define _huffmanbench_h
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "vector.h"
+using namespace std;
+
+struct BenchmarkOptions {
+    size_t minSize;         // smallest generated input
+    size_t maxSize;         // largest generated input (sizes go up by 16x from minSize)
+    string corpusDir;       // directory of extra input files, "" for none
+    string codecFilter;     // only run codecs whose name contains this, "" for all
+    double minSeconds;      // repeat each stage until it has run at least this long
+    BenchmarkOptions();
+};
+
+/*
+ * Runs the benchmark and writes the CSV (with a header row) to out.
+ * Returns false if any codec failed to reproduce its input.
+ */
+bool runBenchmarks(ostream& out, const BenchmarkOptions& options);
+
+/*
+ * Returns the names of the codecs the benchmark knows about.
+ */
+Vector<string> benchmarkCodecNames();
+
+/*
+ * Command-line entry point: [--min-size N] [--max-size N] [--corpus DIR] [--codec NAME]
+ * [--min-seconds S] [--output FILE]. Sizes accept K, M and G suffixes. Returns an exit status.
+ * Building with HUFFMAN_BENCHMARK_MAIN defined makes this the program's main().
+ */
+int benchmarkMain(int argc, char** argv);
+
+#endif
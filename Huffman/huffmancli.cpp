@@ -0,0 +1,548 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the command line declared in huffmancli.h. The arguments are
+ * turned into a list of jobs (one input file and its output file each, with directories expanded
+ * up front), and then a few threads take jobs off the list until it is empty. Every job writes to
+ * a ".part" file that is renamed to the real name only once it is complete, so an interrupted or
+ * failed run never leaves a truncated output that looks finished. Block methods go through the
+ * pipelined driver (pipeline.h), so threads left over when there are fewer files than threads
+ * split a file's blocks between them.
+ */
+
+#include "huffmancli.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "LZW.h"
+#include "bitstream.h"
+#include "blockcodec.h"
+#include "bwt.h"
+#include "encoding.h"
+#include "error.h"
+#include "filelib.h"
+#include "lz77.h"
+#include "map.h"
+#include "pipeline.h"
+#include "strlib.h"
+#include "vector.h"
+#include "wordcoding.h"
+using namespace std;
+
+static const string COMPRESSED_EXTENSION = ".huf";
+static const string DECOMPRESSED_EXTENSION = ".out";
+static const string PARTIAL_EXTENSION = ".part";
+static const int MAX_PARTIAL_ATTEMPTS = 1000;
+static const string STANDARD_STREAM = "-";
+
+enum CliMethod {
+    METHOD_HUFFMAN,
+    METHOD_BLOCK,
+    METHOD_ORDER1,
+    METHOD_TANS,
+    METHOD_LZ77,
+    METHOD_BWT,
+    METHOD_LZW,
+    METHOD_WORDS
+};
+
+static const char* const METHOD_NAMES[] = {"huffman", "block", "order1", "tans", "lz77", "bwt", "lzw", "words"};
+static const int NUM_METHODS = sizeof(METHOD_NAMES) / sizeof(METHOD_NAMES[0]);
+
+/*
+ * The magic bytes each self-identifying format starts with; anything else is taken to be the
+ * original Huffman format, whose header is a frequency table.
+ */
+static const struct {
+    const char* magic;
+    CliMethod method;
+} FORMAT_MAGIC[] = {
+    {"HUFB", METHOD_BLOCK}, {"HLZ7", METHOD_LZ77}, {"HBWT", METHOD_BWT}, {"HLZW", METHOD_LZW},
+    {"HWRD", METHOD_WORDS}
+};
+static const int NUM_FORMATS = sizeof(FORMAT_MAGIC) / sizeof(FORMAT_MAGIC[0]);
+
+struct CliOptions {
+    bool compressing;
+    CliMethod method;
+    int threads;
+    string output;    // -o PATH, "" if not given
+    bool force;
+    bool verbose;
+};
+
+/*
+ * One input and the output it goes to; either may be STANDARD_STREAM.
+ */
+struct CliJob {
+    string input;
+    string output;
+};
+
+/*
+ * Compresses input with the chosen method. The block methods stream through the pipelined driver.
+ * The others need an obitstream; if output isn't one, they write through an obitstream on
+ * output's own buffer, which works because they only ever append whole bytes (through a
+ * BitWriter) and never seek back.
+ */
+static void compressStream(istream& input, ostream& output, CliMethod method, int threads) {
+    if (method == METHOD_BLOCK || method == METHOD_ORDER1 || method == METHOD_TANS) {
+        BlockOptions blockOptions;
+        blockOptions.backend = method == METHOD_ORDER1 ? BACKEND_ORDER1
+                             : method == METHOD_TANS ? BACKEND_TANS : BACKEND_HUFFMAN;
+        PipelineOptions pipeline;
+        pipeline.numWorkers = threads;
+        pipeline.maxInFlight = 2 * threads;
+        compressBlocksPipelined(input, output, blockOptions, pipeline);
+        return;
+    }
+    obitstream* bits = dynamic_cast<obitstream*>(&output);
+    obitstream passThrough;
+    if (bits == NULL) passThrough.rdbuf(output.rdbuf());
+    obitstream& bitOutput = bits != NULL ? *bits : passThrough;
+    if (method == METHOD_HUFFMAN) {
+        compress(input, bitOutput);
+    } else if (method == METHOD_LZ77) {
+        compressLZ77(input, bitOutput);
+    } else if (method == METHOD_BWT) {
+        compressBWT(input, bitOutput);
+    } else if (method == METHOD_LZW) {
+        compressLZW(input, bitOutput);
+    } else {
+        compressWords(input, bitOutput);
+    }
+    if (bits == NULL && !passThrough) output.setstate(ios::badbit); //so the caller sees a failed write
+}
+
+static const int MAGIC_BYTES = 4;
+static const int STDIN_BUFFER_BYTES = 1 << 16;
+
+/*
+ * Returns the method whose format starts with magic (METHOD_HUFFMAN if none does).
+ */
+static CliMethod formatOf(const char magic[], int length) {
+    for (int i = 0; i < NUM_FORMATS; i++) {
+        if (length == MAGIC_BYTES && memcmp(magic, FORMAT_MAGIC[i].magic, MAGIC_BYTES) == 0) {
+            return FORMAT_MAGIC[i].method;
+        }
+    }
+    return METHOD_HUFFMAN;
+}
+
+/*
+ * Decompresses input, which is in method's format and positioned at its start. Except for the
+ * block format, input must be an ibitstream.
+ */
+static void decompressStream(istream& input, ostream& output, CliMethod method, int threads) {
+    if (method == METHOD_BLOCK) {
+        PipelineOptions pipeline;
+        pipeline.numWorkers = threads;
+        pipeline.maxInFlight = 2 * threads;
+        decompressBlocksPipelined(input, output, pipeline);
+        return;
+    }
+    ibitstream* bits = dynamic_cast<ibitstream*>(&input);
+    if (bits == NULL) error("decompressStream: input must be a bit stream");
+    if (method == METHOD_LZ77) {
+        decompressLZ77(*bits, output);
+    } else if (method == METHOD_BWT) {
+        decompressBWT(*bits, output);
+    } else if (method == METHOD_LZW) {
+        decompressLZW(*bits, output);
+    } else if (method == METHOD_WORDS) {
+        decompressWords(*bits, output);
+    } else {
+        decompress(*bits, output);
+    }
+}
+
+/*
+ * Decompresses a file, recognizing its format from the first bytes (which are read and then
+ * the stream is rewound).
+ */
+static void decompressFile(ibitstream& input, ostream& output, int threads) {
+    char magic[MAGIC_BYTES];
+    input.read(magic, MAGIC_BYTES);
+    CliMethod method = formatOf(magic, (int) input.gcount());
+    input.clear();
+    input.seekg(0);
+    decompressStream(input, output, method, threads);
+}
+
+/*
+ * The standard input with the magic bytes that were already read from it put back in front, so
+ * a decoder can read the stream from its start without it ever being rewound. Large reads go
+ * straight to the standard input's own buffer.
+ */
+class PeekedInputBuffer : public streambuf {
+public:
+    PeekedInputBuffer(streambuf* source, const char* peeked, int length) {
+        mySource = source;
+        memcpy(myBuffer, peeked, length);
+        setg(myBuffer, myBuffer, myBuffer + length);
+    }
+
+protected:
+    int_type underflow() {
+        streamsize count = mySource->sgetn(myBuffer, STDIN_BUFFER_BYTES);
+        if (count <= 0) return traits_type::eof();
+        setg(myBuffer, myBuffer, myBuffer + count);
+        return traits_type::to_int_type(myBuffer[0]);
+    }
+
+    streamsize xsgetn(char* bytes, streamsize count) {
+        streamsize buffered = min(count, (streamsize) (egptr() - gptr()));
+        memcpy(bytes, gptr(), buffered);
+        gbump((int) buffered);
+        if (buffered == count) return count;
+        return buffered + mySource->sgetn(bytes + buffered, count - buffered);
+    }
+
+private:
+    PeekedInputBuffer(const PeekedInputBuffer& other);            // not copyable
+    PeekedInputBuffer& operator =(const PeekedInputBuffer& other);
+
+    streambuf* mySource;
+    char myBuffer[STDIN_BUFFER_BYTES];
+};
+
+/*
+ * A read-only, seekable view of bytes already in memory, so a stream can be read (and rewound)
+ * without copying them into a stringbuf first.
+ */
+class MemoryInputBuffer : public streambuf {
+public:
+    MemoryInputBuffer(const string& data) {
+        char* start = const_cast<char*>(data.data()); //only ever read
+        setg(start, start, start + data.size());
+    }
+
+protected:
+    pos_type seekoff(off_type offset, ios::seekdir direction, ios::openmode) {
+        char* base = direction == ios::beg ? eback() : direction == ios::cur ? gptr() : egptr();
+        if (offset < eback() - base || offset > egptr() - base) return pos_type(off_type(-1));
+        setg(eback(), base + offset, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type position, ios::openmode which) {
+        return seekoff(off_type(position), ios::beg, which);
+    }
+
+private:
+    MemoryInputBuffer(const MemoryInputBuffer& other);            // not copyable
+    MemoryInputBuffer& operator =(const MemoryInputBuffer& other);
+};
+
+/*
+ * Compresses or decompresses the standard input. Compressing with a streaming method, and
+ * decompressing anything but the original Huffman format, read the input as it arrives, so a
+ * pipe of any size needs only the codec's own buffers. The original compress reads its input
+ * twice, and the original format is parsed before its data is decoded, so those two read the
+ * whole input into memory first (once, with no further copies).
+ * @threads: threads the job may use for its blocks
+ */
+static void processStandardInput(ostream& output, const CliOptions& options, int threads) {
+    if (options.compressing && options.method != METHOD_HUFFMAN) {
+        compressStream(cin, output, options.method, threads);
+        return;
+    }
+    string data;
+    if (!options.compressing) {
+        char magic[MAGIC_BYTES];
+        cin.read(magic, MAGIC_BYTES);
+        int length = (int) cin.gcount();
+        CliMethod method = formatOf(magic, length);
+        if (method != METHOD_HUFFMAN) {
+            PeekedInputBuffer buffer(cin.rdbuf(), magic, length);
+            ibitstream input;
+            input.rdbuf(&buffer);
+            decompressStream(input, output, method, threads);
+            return;
+        }
+        data.assign(magic, length);
+    }
+    char chunk[STDIN_BUFFER_BYTES];
+    while (true) {
+        streamsize count = cin.rdbuf()->sgetn(chunk, STDIN_BUFFER_BYTES);
+        if (count <= 0) break;
+        data.append(chunk, (size_t) count);
+    }
+    MemoryInputBuffer buffer(data);
+    ibitstream input;
+    input.rdbuf(&buffer);
+    if (options.compressing) {
+        compressStream(input, output, options.method, threads);
+    } else {
+        decompressStream(input, output, METHOD_HUFFMAN, threads);
+    }
+}
+
+/*
+ * Returns the size of a file in bytes (0 if it can't be opened).
+ */
+static uint64_t sizeOfFile(const string& path) {
+    ifstream file(path.c_str(), ifstream::binary | ifstream::ate);
+    return file ? (uint64_t) file.tellg() : 0;
+}
+
+/*
+ * Creates a new, empty ".part" file next to output and returns its name. The file is created
+ * exclusively under a numbered name, so no two jobs (of this run or of another one writing to the
+ * same place) ever write to the same partial file.
+ */
+static string createPartialFile(const string& output) {
+    static atomic<int> counter(0);
+    for (int attempt = 0; attempt < MAX_PARTIAL_ATTEMPTS; attempt++) {
+        string partial = output + "." + integerToString(counter++) + PARTIAL_EXTENSION;
+        FILE* file = fopen(partial.c_str(), "wbx");
+        if (file != NULL) {
+            fclose(file);
+            return partial;
+        }
+        if (errno != EEXIST) break;
+    }
+    error("cannot create a partial file for " + output);
+    return "";
+}
+
+/*
+ * Runs one job. The output is written to a ".part" file of its own next to it and renamed when
+ * done; on failure the partial file is deleted and the error passed on.
+ * @threads: threads the job may use for its blocks
+ */
+static void runJob(const CliJob& job, const CliOptions& options, int threads) {
+    bool toFile = job.output != STANDARD_STREAM;
+    if (toFile && !options.force && fileExists(job.output)) {
+        error(job.output + " already exists (use -f to overwrite it)");
+    }
+    string partial;
+    ofbitstream file;
+    if (toFile) {
+        string directory = getHead(job.output);
+        if (directory != "") createDirectoryPath(directory);
+        partial = createPartialFile(job.output);
+        file.open(partial);
+        if (!file) error("cannot create " + partial);
+    }
+    ostream& output = toFile ? (ostream&) file : cout;
+    try {
+        if (job.input == STANDARD_STREAM) {
+            processStandardInput(output, options, threads);
+        } else {
+            ifbitstream input(job.input);
+            if (!input) error("cannot open " + job.input);
+            if (options.compressing) {
+                compressStream(input, output, options.method, threads);
+            } else {
+                decompressFile(input, output, threads);
+            }
+        }
+        output.flush();
+        if (!output) error("could not write " + (toFile ? job.output : string("the output")));
+    } catch (...) {
+        if (toFile) {
+            file.close();
+            deleteFile(partial);
+        }
+        throw;
+    }
+    if (toFile) {
+        file.close();
+        if (options.force) deleteFile(job.output); //rename won't replace an existing file everywhere
+        if (rename(partial.c_str(), job.output.c_str()) != 0) {
+            deleteFile(partial);
+            error("could not rename " + partial + " to " + job.output);
+        }
+    }
+}
+
+/*
+ * Returns the name a file gets when it is compressed or decompressed.
+ */
+static string outputName(const string& name, bool compressing) {
+    if (compressing) return name + COMPRESSED_EXTENSION;
+    if (endsWith(name, COMPRESSED_EXTENSION)) return name.substr(0, name.size() - COMPRESSED_EXTENSION.size());
+    return name + DECOMPRESSED_EXTENSION;
+}
+
+/*
+ * Adds a job for every file under directory, recursively. Compressing skips files that are
+ * already compressed; decompressing takes only those. Leftover ".part" files are skipped too.
+ * @outputDirectory: where this directory's outputs go, or "" for next to the inputs
+ */
+static void addDirectoryJobs(const string& directory, const string& outputDirectory, bool compressing,
+                             Vector<CliJob>& jobs) {
+    Vector<string> names;
+    listDirectory(directory, names);
+    string separator = getDirectoryPathSeparator();
+    for (int i = 0; i < names.size(); i++) {
+        string path = directory + separator + names[i];
+        string output = outputDirectory == "" ? path : outputDirectory + separator + names[i];
+        if (isDirectory(path)) {
+            addDirectoryJobs(path, outputDirectory == "" ? "" : output, compressing, jobs);
+        } else if (isFile(path) && !endsWith(names[i], PARTIAL_EXTENSION)
+                   && endsWith(names[i], COMPRESSED_EXTENSION) != compressing) {
+            CliJob job = {path, outputName(output, compressing)};
+            jobs.add(job);
+        }
+    }
+}
+
+/*
+ * Turns the command line's inputs into jobs.
+ * Throws an error if an input doesn't exist, or if two inputs would be written to the same file
+ * (such as files of the same name in two directories given with -o).
+ */
+static void collectJobs(const Vector<string>& inputs, const CliOptions& options, Vector<CliJob>& jobs) {
+    string separator = getDirectoryPathSeparator();
+    bool singleOutput = inputs.size() == 1 && options.output != "" && !isDirectory(options.output);
+    for (int i = 0; i < inputs.size(); i++) {
+        const string& input = inputs[i];
+        if (input == STANDARD_STREAM) {
+            CliJob job = {input, options.output == "" ? STANDARD_STREAM : options.output};
+            jobs.add(job);
+        } else if (isDirectory(input)) {
+            string directory = input;
+            while (directory.size() > 1 && endsWith(directory, separator)) {
+                directory.erase(directory.size() - 1);
+            }
+            addDirectoryJobs(directory, options.output, options.compressing, jobs);
+        } else if (isFile(input)) {
+            string output = singleOutput ? options.output
+                          : options.output == "" ? outputName(input, options.compressing)
+                          : options.output + separator + outputName(getTail(input), options.compressing);
+            CliJob job = {input, output};
+            jobs.add(job);
+        } else {
+            error(input + ": no such file or directory");
+        }
+    }
+    Map<string, string> inputsByOutput;
+    for (int i = 0; i < jobs.size(); i++) {
+        const CliJob& job = jobs[i];
+        if (job.output == STANDARD_STREAM) continue;
+        if (inputsByOutput.containsKey(job.output)) {
+            error(inputsByOutput[job.output] + " and " + job.input + " would both be written to " + job.output);
+        }
+        inputsByOutput.put(job.output, job.input);
+    }
+}
+
+/*
+ * Runs the jobs on up to options.threads threads, one job per thread at a time; when there are
+ * fewer jobs than threads, each job gets the spare threads for its blocks. Failures are reported
+ * as they happen and don't stop the other jobs.
+ * Returns the number of jobs that failed.
+ */
+static int runJobs(const Vector<CliJob>& jobs, const CliOptions& options) {
+    int jobThreads = max(1, min(options.threads, jobs.size()));
+    int blockThreads = max(1, options.threads / jobThreads);
+    atomic<int> next(0);
+    atomic<int> failures(0);
+    mutex reportLock;
+    auto worker = [&]() {
+        while (true) {
+            int i = next++;
+            if (i >= jobs.size()) break;
+            const CliJob& job = jobs[i];
+            string message;
+            try {
+                runJob(job, options, blockThreads);
+            } catch (ErrorException& ex) {
+                message = ex.getMessage();
+            } catch (exception& ex) {
+                message = ex.what();
+            }
+            lock_guard<mutex> lock(reportLock);
+            if (message != "") {
+                failures++;
+                cerr << "huffman: " << job.input << ": " << message << endl;
+            } else if (options.verbose && job.input != STANDARD_STREAM && job.output != STANDARD_STREAM) {
+                cerr << job.input << " (" << sizeOfFile(job.input) << " bytes) -> "
+                     << job.output << " (" << sizeOfFile(job.output) << " bytes)" << endl;
+            }
+        }
+    };
+    Vector<thread*> threads;
+    for (int i = 1; i < jobThreads; i++) {
+        threads.add(new thread(worker));
+    }
+    worker();
+    for (int i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    return failures;
+}
+
+static int usage(const char* program) {
+    cerr << "usage: " << program << " [-c | -d] [-m METHOD] [-j N] [-o PATH] [-f] [-v] [FILE | DIR | -]..." << endl;
+    cerr << "  methods:";
+    for (int i = 0; i < NUM_METHODS; i++) {
+        cerr << " " << METHOD_NAMES[i];
+    }
+    cerr << endl;
+    return 2;
+}
+
+int huffmanCli(int argc, char** argv) {
+    CliOptions options;
+    options.compressing = true;
+    options.method = METHOD_BLOCK;
+    options.threads = max(1, (int) thread::hardware_concurrency());
+    options.force = false;
+    options.verbose = false;
+    Vector<string> inputs;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-c") {
+            options.compressing = true;
+        } else if (arg == "-d") {
+            options.compressing = false;
+        } else if (arg == "-f") {
+            options.force = true;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "-j" && hasValue) {
+            options.threads = atoi(argv[++i]);
+            if (options.threads < 1) return usage(argv[0]);
+        } else if (arg == "-o" && hasValue) {
+            options.output = argv[++i];
+        } else if (arg == "-m" && hasValue) {
+            string name = argv[++i];
+            int m = 0;
+            while (m < NUM_METHODS && name != METHOD_NAMES[m]) m++;
+            if (m == NUM_METHODS) return usage(argv[0]);
+            options.method = (CliMethod) m;
+        } else if (arg != STANDARD_STREAM && startsWith(arg, "-")) {
+            return usage(argv[0]);
+        } else {
+            inputs.add(arg);
+        }
+    }
+    if (inputs.isEmpty()) inputs.add(STANDARD_STREAM);
+
+    Vector<CliJob> jobs;
+    try {
+        collectJobs(inputs, options, jobs);
+    } catch (ErrorException& ex) {
+        cerr << "huffman: " << ex.getMessage() << endl;
+        return 1;
+    }
+    return runJobs(jobs, options) == 0 ? 0 : 1;
+}
+
+#ifdef HUFFMAN_CLI_MAIN
+int main(int argc, char** argv) {
+    return huffmanCli(argc, argv);
+}
+#endif
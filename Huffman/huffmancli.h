@@ -0,0 +1,35 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the huffmancli.h file which declares the non-interactive command line. It does what the
+ * menu's compress and decompress items do, without any prompts, so it can run from scripts and
+ * cron jobs: files, whole directory trees and stdin/stdout, with independent files compressed or
+ * decompressed on several threads at once.
+ *
+ * usage: huffman [-c | -d] [-m METHOD] [-j N] [-o PATH] [-f] [-v] [FILE | DIR | -]...
+ *   -c         compress (the default)
+ *   -d         decompress; the method is recognized from the compressed data
+ *   -m METHOD  huffman (the original format), block (the default), order1, tans, lz77, bwt, lzw
+ *              or words (word-level codes, for text)
+ *   -j N       use N threads (default: one per core); several files are processed at once, and a
+ *              single file in a block method is split across the threads
+ *   -o PATH    output file for a single input, otherwise the directory the outputs go under
+ *              (mirroring the input directories); without it outputs go next to the inputs
+ *   -f         overwrite existing output files instead of reporting them as errors
+ *   -v         print one line per file with its sizes
+ * With no inputs, or "-", stdin is processed to stdout (or to -o). Compressing adds ".huf" to a
+ * file's name and decompressing takes it off (or adds ".out" if it isn't there). Directories are
+ * walked recursively; compressing skips files already ending in ".huf" and decompressing only
+ * looks at them. Input files are never deleted, and an output only appears once it is complete.
+ */
+
+#ifndef _huffmancli_h
+#define _huffmancli_h
+
+/*
+ * Runs the command line. Returns 0 if every input was processed, 1 if any failed (each failure
+ * is reported on cerr and the rest still run), or 2 for a usage error.
+ * Building with HUFFMAN_CLI_MAIN defined makes this the program's main().
+ */
+int huffmanCli(int argc, char** argv);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements canonical Huffman codes and their decode tables. Codes are
+ * assigned the same way DEFLATE does it: count how many codes there are of each length, work out
+ * the first code of each length from those counts, then hand out codes in character order.
+ */
+
+#include "huffmancode.h"
+#include <cstring>
+#include "error.h"
+
+static const int MAX_CODE_BITS = 32;
+
+/*
+ * Returns the low length bits of code in the opposite order.
+ */
+static uint32_t reverseBits(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+HuffmanCode::HuffmanCode() {
+    myLengths = NULL;
+    myBits = NULL;
+    myNumSymbols = 0;
+    myCapacity = 0;
+    myMaxLength = 0;
+}
+
+HuffmanCode::~HuffmanCode() {
+    delete[] myLengths;
+    delete[] myBits;
+}
+
+/*
+ * Big-Oh: O(N)
+ * @lengths: the code length of each character
+ * @numSymbols: the number of characters
+ */
+void HuffmanCode::build(const int lengths[], int numSymbols) {
+    if (numSymbols > myCapacity) {
+        delete[] myLengths;
+        delete[] myBits;
+        myCapacity = numSymbols;
+        myLengths = new int[myCapacity];
+        myBits = new uint32_t[myCapacity];
+    }
+    myNumSymbols = numSymbols;
+    myMaxLength = 0;
+
+    int lengthCounts[MAX_CODE_BITS + 1] = {0};
+    for (int ch = 0; ch < numSymbols; ch++) {
+        if (lengths[ch] < 0 || lengths[ch] > MAX_CODE_BITS) {
+            error("HuffmanCode::build: invalid code length");
+        }
+        myLengths[ch] = lengths[ch];
+        lengthCounts[lengths[ch]]++;
+        if (lengths[ch] > myMaxLength) myMaxLength = lengths[ch];
+    }
+
+    uint64_t nextCode[MAX_CODE_BITS + 2];
+    uint64_t code = 0;
+    lengthCounts[0] = 0;
+    for (int len = 1; len <= MAX_CODE_BITS; len++) { //first code of each length
+        code = (code + lengthCounts[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+    for (int ch = 0; ch < numSymbols; ch++) {
+        int len = myLengths[ch];
+        if (len == 0) {
+            myBits[ch] = 0;
+        } else {
+            if (nextCode[len] >> len) error("HuffmanCode::build: code lengths are oversubscribed");
+            myBits[ch] = reverseBits((uint32_t) nextCode[len]++, len);
+        }
+    }
+}
+
+int HuffmanCode::numSymbols() const {
+    return myNumSymbols;
+}
+
+int HuffmanCode::maxLength() const {
+    return myMaxLength;
+}
+
+int HuffmanCode::length(int ch) const {
+    return myLengths[ch];
+}
+
+uint32_t HuffmanCode::bits(int ch) const {
+    return myBits[ch];
+}
+
+string HuffmanCode::toString(int ch) const {
+    string s;
+    for (int i = 0; i < myLengths[ch]; i++) {
+        s += ((myBits[ch] >> i) & 1) ? '1' : '0';
+    }
+    return s;
+}
+
+HuffmanDecodeTable::HuffmanDecodeTable() {
+    myEntries = NULL;
+    myMask = 0;
+    myTableBits = 0;
+    myCapacity = 0;
+}
+
+HuffmanDecodeTable::~HuffmanDecodeTable() {
+    delete[] myEntries;
+}
+
+/*
+ * Every index whose low bits equal a character's (reversed) code maps to that character, so a
+ * code of length L fills 2^(tableBits - L) entries spaced 2^L apart.
+ * Big-Oh: O(2^tableBits)
+ * @code: the canonical code to decode
+ */
+void HuffmanDecodeTable::build(const HuffmanCode& code) {
+    int bits = code.maxLength();
+    if (bits > MAX_DECODE_TABLE_BITS) {
+        error("HuffmanDecodeTable::build: codes are too long for a decode table");
+    }
+    if (bits == 0) bits = 1;
+    int size = 1 << bits;
+    if (size > myCapacity) {
+        delete[] myEntries;
+        myCapacity = size;
+        myEntries = new uint32_t[myCapacity];
+    }
+    memset(myEntries, 0, size * sizeof(uint32_t));
+    myTableBits = bits;
+    myMask = (uint32_t) size - 1;
+    for (int ch = 0; ch < code.numSymbols(); ch++) {
+        int len = code.length(ch);
+        if (len == 0) continue;
+        uint32_t entry = ((uint32_t) ch << 8) | (uint32_t) len;
+        for (uint32_t index = code.bits(ch); index < (uint32_t) size; index += (uint32_t) 1 << len) {
+            myEntries[index] = entry;
+        }
+    }
+}
+
+int HuffmanDecodeTable::tableBits() const {
+    return myTableBits;
+}
@@ -0,0 +1,103 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the huffmancode.h file which declares canonical Huffman codes and the table used to
+ * decode them. A canonical code is completely described by each character's code length, so
+ * a compressed format only has to store the lengths, and because lengths can be limited (see
+ * HuffmanPool::codeLengths) the decoder can find every character with a single table lookup.
+ */
+
+#ifndef _huffmancode_h
+#define _huffmancode_h
+
+#include <cstdint>
+#include <string>
+using namespace std;
+
+const int DEFAULT_MAX_CODE_LENGTH = 12;  // length limit used when a caller doesn't pick one
+const int MAX_DECODE_TABLE_BITS = 20;    // longest code a HuffmanDecodeTable can hold (2^20 entries)
+
+/*
+ * A canonical Huffman code: codes of the same length are consecutive binary numbers
+ * assigned in character order, and shorter codes come before longer ones.
+ */
+class HuffmanCode {
+public:
+    HuffmanCode();
+    ~HuffmanCode();
+
+    /*
+     * Assigns canonical codes for characters 0 .. numSymbols-1 given their code lengths
+     * (0 meaning the character has no code). Lengths may be at most 32.
+     */
+    void build(const int lengths[], int numSymbols);
+
+    int numSymbols() const;
+    int maxLength() const;     // longest code length in use
+    int length(int ch) const;  // length of ch's code, 0 if it has none
+
+    /*
+     * Returns ch's code with its bits reversed, i.e. the first bit of the code in the
+     * lowest position. That is the order BitWriter and obitstream put bits into a byte.
+     */
+    uint32_t bits(int ch) const;
+
+    /*
+     * Returns ch's code as a string of '0' and '1' characters, like buildEncodingMap.
+     */
+    string toString(int ch) const;
+
+private:
+    HuffmanCode(const HuffmanCode& other);            // not copyable (owns its arrays)
+    HuffmanCode& operator =(const HuffmanCode& other);
+
+    int* myLengths;
+    uint32_t* myBits;
+    int myNumSymbols;
+    int myCapacity;
+    int myMaxLength;
+};
+
+/*
+ * A lookup table for decoding a HuffmanCode. It has 2^maxLength entries indexed by the next
+ * maxLength bits of input (first bit lowest); each entry holds the character whose code starts
+ * those bits, and that code's length. Unused entries have length 0.
+ */
+class HuffmanDecodeTable {
+public:
+    HuffmanDecodeTable();
+    ~HuffmanDecodeTable();
+
+    /*
+     * Fills in the table for the given code. Throws an error if its codes are longer than
+     * MAX_DECODE_TABLE_BITS.
+     */
+    void build(const HuffmanCode& code);
+
+    int tableBits() const;
+
+    /*
+     * Looks up the entry for the given upcoming input bits (only the low tableBits() are used).
+     */
+    uint32_t entry(uint64_t upcomingBits) const {
+        return myEntries[upcomingBits & myMask];
+    }
+
+    static int entrySymbol(uint32_t entry) {
+        return (int) (entry >> 8);
+    }
+
+    static int entryLength(uint32_t entry) {
+        return (int) (entry & 0xff);
+    }
+
+private:
+    HuffmanDecodeTable(const HuffmanDecodeTable& other);            // not copyable (owns its array)
+    HuffmanDecodeTable& operator =(const HuffmanDecodeTable& other);
+
+    uint32_t* myEntries;
+    uint32_t myMask;
+    int myTableBits;
+    int myCapacity;
+};
+
+#endif
@@ -0,0 +1,449 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the LZ77 + Huffman codec declared in lz77.h. The encoder keeps
+ * the last 32 KB of input in front of the block being compressed and indexes every position by a
+ * hash of its next three bytes; positions with the same hash are chained together, so finding the
+ * longest earlier match means walking one short chain. Each block's symbols are buffered, counted,
+ * and then written with length-limited canonical codes from HuffmanPool and HuffmanCode. The
+ * decoder finds every symbol with one HuffmanDecodeTable lookup and copies matches out of its own
+ * output window.
+ */
+
+#include "lz77.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "error.h"
+#include "huffmancode.h"
+#include "strlib.h"
+
+static const char LZ77_MAGIC[] = "HLZ7";
+static const int LZ77_VERSION = 1;
+static const int LZ77_HEADER_BYTES = 6;
+static const int HASH_BITS = 15;
+static const int WINDOW_MASK = LZ77_WINDOW_SIZE - 1;
+static const int OUTPUT_CHUNK_BYTES = 1 << 16; //decoded bytes written at a time
+static const int NUM_LENGTH_CODES = 29;
+
+// DEFLATE's length and distance codes: the smallest value each code stands for, and how many
+// extra bits follow it to pick a value in its range
+static const int LENGTH_BASE[NUM_LENGTH_CODES] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+    131, 163, 195, 227, 258
+};
+static const int LENGTH_EXTRA[NUM_LENGTH_CODES] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int DISTANCE_BASE[LZ77_DISTANCE_SYMBOLS] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+    2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int DISTANCE_EXTRA[LZ77_DISTANCE_SYMBOLS] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/*
+ * How hard each level looks for matches, in the spirit of zlib's configuration table.
+ */
+struct LevelSettings {
+    int goodLength;   // search only a quarter of the chain to improve on a match this long
+    int lazyLength;   // lazy levels: don't look for a better match than one this long;
+                      // greedy levels: don't add the positions inside longer matches to the chains
+    int niceLength;   // stop searching once a match is at least this long
+    int maxChain;     // most earlier positions to try for one match
+    bool lazy;        // before taking a match, see if the next position has a longer one
+};
+
+static const LevelSettings LEVELS[LZ77_MAX_LEVEL + 1] = {
+    {0, 0, 0, 0, false}, //no level 0
+    {4, 4, 8, 4, false}, {4, 5, 16, 8, false}, {4, 6, 32, 32, false},
+    {4, 4, 16, 16, true}, {8, 16, 32, 32, true}, {8, 16, 128, 128, true},
+    {8, 32, 128, 256, true}, {32, 128, 258, 1024, true}, {32, 258, 258, 4096, true}
+};
+
+/*
+ * Returns the code (0 to NUM_LENGTH_CODES - 1) of a match length; binary search keeps it to a few steps.
+ */
+static int lengthCode(int length) {
+    return (int) (upper_bound(LENGTH_BASE, LENGTH_BASE + NUM_LENGTH_CODES, length) - LENGTH_BASE) - 1;
+}
+
+static int distanceCode(int distance) {
+    return (int) (upper_bound(DISTANCE_BASE, DISTANCE_BASE + LZ77_DISTANCE_SYMBOLS, distance) - DISTANCE_BASE) - 1;
+}
+
+/*
+ * The encoder's window and hash chains. Positions are indexes into data, which holds up to
+ * LZ77_WINDOW_SIZE bytes of history followed by the block being compressed.
+ */
+class LZ77MatchFinder {
+public:
+    LZ77MatchFinder() {
+        myData = new unsigned char[LZ77_WINDOW_SIZE + LZ77_BLOCK_BYTES];
+        myHead = new int[1 << HASH_BITS];
+        myPrev = new int[LZ77_WINDOW_SIZE];
+        for (int i = 0; i < (1 << HASH_BITS); i++) {
+            myHead[i] = -1;
+        }
+    }
+
+    ~LZ77MatchFinder() {
+        delete[] myData;
+        delete[] myHead;
+        delete[] myPrev;
+    }
+
+    unsigned char* data() {
+        return myData;
+    }
+
+    /*
+     * Adds pos to the chain for its next three bytes (which must all be in the window).
+     */
+    void insert(int pos) {
+        int h = hash(pos);
+        myPrev[pos & WINDOW_MASK] = myHead[h];
+        myHead[h] = pos;
+    }
+
+    /*
+     * Returns the length of the longest match for pos among the earlier positions on its chain
+     * (trying at most maxChain of them), or 0 if there is none of at least LZ77_MIN_MATCH bytes
+     * and longer than toBeat. Matches don't run past end. Sets distance to how far back the match is.
+     */
+    int longestMatch(int pos, int end, const LevelSettings& settings, int toBeat, int& distance) const {
+        int limit = min(LZ77_MAX_MATCH, end - pos);
+        if (limit < LZ77_MIN_MATCH) return 0;
+        const unsigned char* current = myData + pos;
+        int best = max(LZ77_MIN_MATCH - 1, toBeat);
+        if (best >= limit) return 0;
+        int chain = toBeat >= settings.goodLength ? settings.maxChain >> 2 : settings.maxChain;
+        int candidate = myHead[hash(pos)];
+        while (candidate >= 0 && pos - candidate <= LZ77_WINDOW_SIZE && chain-- > 0) {
+            const unsigned char* earlier = myData + candidate;
+            if (earlier[best] == current[best] && earlier[0] == current[0]) { //cheap checks first
+                int length = 0;
+                while (length + 8 <= limit) { //eight bytes at a time until they differ
+                    uint64_t a;
+                    uint64_t b;
+                    memcpy(&a, earlier + length, 8);
+                    memcpy(&b, current + length, 8);
+                    if (a != b) break;
+                    length += 8;
+                }
+                while (length < limit && earlier[length] == current[length]) {
+                    length++;
+                }
+                if (length > best) {
+                    best = length;
+                    distance = pos - candidate;
+                    if (length >= settings.niceLength || length == limit) break;
+                }
+            }
+            int next = myPrev[candidate & WINDOW_MASK];
+            if (next >= candidate) break; //that slot has been reused by a newer position
+            candidate = next;
+        }
+        return best >= LZ77_MIN_MATCH && best > toBeat ? best : 0;
+    }
+
+    /*
+     * Drops the first shift bytes (a multiple of LZ77_WINDOW_SIZE) and renumbers the chains to match.
+     */
+    void slide(int shift, int end) {
+        memmove(myData, myData + shift, end - shift);
+        for (int i = 0; i < (1 << HASH_BITS); i++) {
+            myHead[i] = myHead[i] >= shift ? myHead[i] - shift : -1;
+        }
+        for (int i = 0; i < LZ77_WINDOW_SIZE; i++) {
+            myPrev[i] = myPrev[i] >= shift ? myPrev[i] - shift : -1;
+        }
+    }
+
+private:
+    unsigned char* myData;
+    int* myHead;  // most recent position with each hash, -1 for none
+    int* myPrev;  // the position before each one (by pos & WINDOW_MASK) with the same hash
+
+    int hash(int pos) const {
+        const unsigned char* p = myData + pos;
+        uint32_t key = (uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | p[2];
+        return (int) ((key * 2654435761u) >> (32 - HASH_BITS));
+    }
+
+    LZ77MatchFinder(const LZ77MatchFinder&); //not copyable
+    LZ77MatchFinder& operator =(const LZ77MatchFinder&);
+};
+
+/*
+ * Packs a match into one symbol word: literal/length symbol (9 bits), length extra bits (5),
+ * distance symbol (5), distance extra bits (13). A literal is just its byte.
+ */
+static uint32_t matchSymbol(int length, int distance) {
+    int lc = lengthCode(length);
+    int dc = distanceCode(distance);
+    return (uint32_t) (LZ77_END_OF_BLOCK + 1 + lc) | (uint32_t) (length - LENGTH_BASE[lc]) << 9
+            | (uint32_t) dc << 14 | (uint32_t) (distance - DISTANCE_BASE[dc]) << 19;
+}
+
+/*
+ * Turns the bytes from pos to end into literal and match symbols. With lazy matching, a match
+ * is put off by one byte when the next position has a longer one.
+ * @finder: the window, with everything before pos already in the hash chains
+ * @symbols: where the symbols are stored
+ * Returns the number of symbols.
+ */
+static int findMatches(LZ77MatchFinder& finder, int pos, int end, const LevelSettings& settings,
+                       uint32_t symbols[]) {
+    const unsigned char* data = finder.data();
+    int count = 0;
+    int lookaheadPos = -1; //position whose match was already found by the lazy check
+    int lookaheadLength = 0;
+    int lookaheadDistance = 0;
+    while (pos < end) {
+        int distance = lookaheadDistance;
+        int length = pos == lookaheadPos ? lookaheadLength : finder.longestMatch(pos, end, settings, 0, distance);
+        if (pos + LZ77_MIN_MATCH <= end) finder.insert(pos);
+        if (length > 0 && settings.lazy && length < settings.lazyLength) {
+            lookaheadPos = pos + 1;
+            lookaheadLength = finder.longestMatch(lookaheadPos, end, settings, length, lookaheadDistance);
+            if (lookaheadLength > 0) {
+                length = 0; //take a literal now and the longer match next time around
+            }
+        }
+        if (length == 0) {
+            symbols[count++] = data[pos];
+            pos++;
+        } else {
+            symbols[count++] = matchSymbol(length, distance);
+            if (settings.lazy || length <= settings.lazyLength) {
+                for (int i = 1; i < length; i++) {
+                    if (pos + i + LZ77_MIN_MATCH <= end) finder.insert(pos + i);
+                }
+            }
+            pos += length;
+        }
+    }
+    return count;
+}
+
+/*
+ * Builds length-limited code lengths for the given symbol counts.
+ */
+static void buildCodeLengths(const uint64_t counts[], int numSymbols, int lengths[]) {
+    HuffmanPool pool;
+    pool.build(counts, numSymbols);
+    pool.codeLengths(lengths, numSymbols, LZ77_MAX_CODE_LENGTH);
+}
+
+/*
+ * Writes one block: its code lengths, then every symbol and the end-of-block symbol.
+ * @symbols: the block's symbols from findMatches
+ * @count: the number of symbols
+ * @last: whether this is the stream's final block
+ * @writer: where the bits go
+ */
+static void writeBlock(const uint32_t symbols[], int count, bool last, BitWriter& writer) {
+    uint64_t litCounts[LZ77_LITLEN_SYMBOLS] = {0};
+    uint64_t distCounts[LZ77_DISTANCE_SYMBOLS] = {0};
+    for (int i = 0; i < count; i++) {
+        int lit = symbols[i] & 0x1ff;
+        litCounts[lit]++;
+        if (lit > LZ77_END_OF_BLOCK) distCounts[(symbols[i] >> 14) & 0x1f]++;
+    }
+    litCounts[LZ77_END_OF_BLOCK]++;
+    int lengths[LZ77_LITLEN_SYMBOLS + LZ77_DISTANCE_SYMBOLS];
+    int* litLengths = lengths;
+    int* distLengths = lengths + LZ77_LITLEN_SYMBOLS;
+    buildCodeLengths(litCounts, LZ77_LITLEN_SYMBOLS, litLengths);
+    buildCodeLengths(distCounts, LZ77_DISTANCE_SYMBOLS, distLengths);
+
+    int numLit = LZ77_LITLEN_SYMBOLS;
+    while (numLit > LZ77_END_OF_BLOCK + 1 && litLengths[numLit - 1] == 0) numLit--;
+    int numDist = LZ77_DISTANCE_SYMBOLS;
+    while (numDist > 0 && distLengths[numDist - 1] == 0) numDist--;
+    writer.writeBit(last ? 1 : 0);
+    writer.writeBits(numLit - (LZ77_END_OF_BLOCK + 1), 5);
+    writer.writeBits(numDist, 5);
+    for (int i = 0; i < numLit; i++) {
+        writer.writeBits(litLengths[i], 4);
+    }
+    for (int i = 0; i < numDist; i++) {
+        writer.writeBits(distLengths[i], 4);
+    }
+
+    HuffmanCode litCode;
+    litCode.build(litLengths, numLit);
+    HuffmanCode distCode;
+    distCode.build(distLengths, numDist);
+    uint32_t litBits[LZ77_LITLEN_SYMBOLS];
+    uint32_t distBits[LZ77_DISTANCE_SYMBOLS];
+    for (int i = 0; i < numLit; i++) {
+        litBits[i] = litCode.bits(i);
+    }
+    for (int i = 0; i < numDist; i++) {
+        distBits[i] = distCode.bits(i);
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint32_t symbol = symbols[i];
+        int lit = symbol & 0x1ff;
+        writer.writeBits(litBits[lit], litLengths[lit]);
+        if (lit > LZ77_END_OF_BLOCK) {
+            int dist = (symbol >> 14) & 0x1f;
+            writer.writeBits((symbol >> 9) & 0x1f, LENGTH_EXTRA[lit - LZ77_END_OF_BLOCK - 1]);
+            writer.writeBits(distBits[dist], distLengths[dist]);
+            writer.writeBits(symbol >> 19, DISTANCE_EXTRA[dist]);
+        }
+    }
+    writer.writeBits(litBits[LZ77_END_OF_BLOCK], litLengths[LZ77_END_OF_BLOCK]);
+}
+
+/*
+ * Reads the input a block at a time behind LZ77_WINDOW_SIZE bytes of history, turns it into
+ * symbols and writes them as a block, then slides the window along.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ * @level: LZ77_MIN_LEVEL (fastest) to LZ77_MAX_LEVEL (smallest)
+ */
+void compressLZ77(istream& input, obitstream& output, int level) {
+    if (level < LZ77_MIN_LEVEL || level > LZ77_MAX_LEVEL) {
+        error("compressLZ77: level must be between " + integerToString(LZ77_MIN_LEVEL)
+              + " and " + integerToString(LZ77_MAX_LEVEL));
+    }
+    output.write(LZ77_MAGIC, 4);
+    output.put((char) LZ77_VERSION);
+    output.put((char) level);
+
+    LZ77MatchFinder finder;
+    uint32_t* symbols = new uint32_t[LZ77_BLOCK_BYTES];
+    BitWriter writer(output);
+    int end = 0; //bytes in the window
+    while (true) {
+        input.read((char*) finder.data() + end, LZ77_BLOCK_BYTES);
+        int length = (int) input.gcount();
+        bool last = length < LZ77_BLOCK_BYTES;
+        int count = findMatches(finder, end, end + length, LEVELS[level], symbols);
+        end += length;
+        writeBlock(symbols, count, last, writer);
+        if (last) break;
+        if (end > LZ77_WINDOW_SIZE) { //keep only the last LZ77_WINDOW_SIZE bytes as history
+            int shift = end - LZ77_WINDOW_SIZE;
+            finder.slide(shift, end);
+            end -= shift;
+        }
+    }
+    delete[] symbols;
+    writer.flush();
+}
+
+/*
+ * Reads the next code from the window using table, returning its symbol or -1 if the bits
+ * are not a valid code or the input has run out.
+ */
+static inline int readSymbol(BitReader& reader, const HuffmanDecodeTable& table) {
+    uint32_t entry = table.entry(reader.window());
+    int length = HuffmanDecodeTable::entryLength(entry);
+    if (length == 0 || length > reader.bitsAvailable()) return -1;
+    reader.consume(length);
+    return HuffmanDecodeTable::entrySymbol(entry);
+}
+
+/*
+ * Reads count extra bits from the window, or returns -1 if the input has run out.
+ */
+static inline int readExtra(BitReader& reader, int count) {
+    if (count > reader.bitsAvailable()) return -1;
+    int bits = (int) (reader.window() & ((1u << count) - 1));
+    reader.consume(count);
+    return bits;
+}
+
+/*
+ * Decodes block after block into an output buffer that keeps the last LZ77_WINDOW_SIZE bytes
+ * for matches to copy from, writing it out in chunks. One refill of the reader's window covers
+ * a whole literal or match (at most 48 bits).
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ */
+void decompressLZ77(ibitstream& input, ostream& output) {
+    unsigned char header[LZ77_HEADER_BYTES];
+    input.read((char*) header, LZ77_HEADER_BYTES);
+    if (input.gcount() != LZ77_HEADER_BYTES || memcmp(header, LZ77_MAGIC, 4) != 0) {
+        error("decompressLZ77: not an LZ77-compressed stream");
+    }
+    if (header[4] != LZ77_VERSION) {
+        error("decompressLZ77: unsupported LZ77 stream version");
+    }
+
+    BitReader reader(input);
+    string buffer(LZ77_WINDOW_SIZE + OUTPUT_CHUNK_BYTES + LZ77_MAX_MATCH, '\0');
+    unsigned char* out = (unsigned char*) &buffer[0];
+    int pos = 0;      //next byte of out to fill
+    int flushed = 0;  //bytes of out already written
+    HuffmanCode litCode;
+    HuffmanCode distCode;
+    HuffmanDecodeTable litTable;
+    HuffmanDecodeTable distTable;
+    bool last = false;
+    bool ok = true;
+    while (ok && !last) {
+        int64_t blockHeader = reader.readBits(11);
+        int numLit = LZ77_END_OF_BLOCK + 1 + (int) ((blockHeader >> 1) & 0x1f);
+        int numDist = (int) (blockHeader >> 6);
+        if (blockHeader < 0 || numLit > LZ77_LITLEN_SYMBOLS || numDist > LZ77_DISTANCE_SYMBOLS) break;
+        last = (blockHeader & 1) != 0;
+        int lengths[LZ77_LITLEN_SYMBOLS + LZ77_DISTANCE_SYMBOLS];
+        for (int i = 0; i < numLit + numDist && ok; i++) {
+            int64_t length = reader.readBits(4);
+            lengths[i] = (int) length;
+            ok = length >= 0;
+        }
+        if (!ok) break;
+        litCode.build(lengths, numLit);
+        distCode.build(lengths + numLit, numDist);
+        litTable.build(litCode);
+        distTable.build(distCode);
+
+        while (true) {
+            reader.refill();
+            int symbol = readSymbol(reader, litTable);
+            if (symbol < LZ77_END_OF_BLOCK) {
+                if (symbol < 0) {
+                    ok = false;
+                    break;
+                }
+                out[pos++] = (unsigned char) symbol;
+            } else if (symbol == LZ77_END_OF_BLOCK) {
+                break;
+            } else {
+                int lc = symbol - LZ77_END_OF_BLOCK - 1;
+                int lengthExtra = lc < NUM_LENGTH_CODES ? readExtra(reader, LENGTH_EXTRA[lc]) : -1;
+                int dc = lengthExtra >= 0 ? readSymbol(reader, distTable) : -1;
+                int distanceExtra = dc >= 0 ? readExtra(reader, DISTANCE_EXTRA[dc]) : -1;
+                int distance = distanceExtra >= 0 ? DISTANCE_BASE[dc] + distanceExtra : pos + 1;
+                if (distance > pos) { //also covers any of the reads above failing
+                    ok = false;
+                    break;
+                }
+                int length = LENGTH_BASE[lc] + lengthExtra;
+                const unsigned char* from = out + pos - distance;
+                for (int i = 0; i < length; i++) { //byte by byte, since the copy may overlap itself
+                    out[pos + i] = from[i];
+                }
+                pos += length;
+            }
+            if (pos >= LZ77_WINDOW_SIZE + OUTPUT_CHUNK_BYTES) {
+                output.write((const char*) out + flushed, pos - flushed);
+                memmove(out, out + pos - LZ77_WINDOW_SIZE, LZ77_WINDOW_SIZE);
+                pos = LZ77_WINDOW_SIZE;
+                flushed = pos;
+            }
+        }
+    }
+    output.write((const char*) out + flushed, pos - flushed);
+    if (!ok || !last) error("decompressLZ77: compressed data is corrupt or truncated");
+}
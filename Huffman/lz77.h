@@ -0,0 +1,47 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the lz77.h file which declares the LZ77 + Huffman codec, the same combination DEFLATE
+ * uses. A match finder with hash chains over a 32 KB sliding window turns the input into literal
+ * bytes and (length, distance) pairs that point back at earlier copies of the same bytes. Those
+ * symbols are then Huffman coded with canonical codes (huffmancode.h) built per block from their
+ * own counts, so both repeated strings and skewed byte frequencies are squeezed out.
+ *
+ * Stream layout: "HLZ7", version byte, level byte, then blocks in one bit stream (first bit lowest).
+ * Each block is: a last-block bit, the number of literal/length codes minus 257 (5 bits), the
+ * number of distance codes (5 bits), their code lengths (4 bits each), then the coded symbols
+ * ending with LZ77_END_OF_BLOCK. Lengths and distances use DEFLATE's code tables and extra bits.
+ */
+
+#ifndef _lz77_h
+#define _lz77_h
+
+#include <iostream>
+#include "bitstream.h"
+using namespace std;
+
+const int LZ77_WINDOW_SIZE = 1 << 15;     // how far back a match may point
+const int LZ77_MIN_MATCH = 3;
+const int LZ77_MAX_MATCH = 258;
+const int LZ77_BLOCK_BYTES = 1 << 18;     // input covered by one block's Huffman codes
+const int LZ77_MAX_CODE_LENGTH = 15;
+const int LZ77_END_OF_BLOCK = 256;        // literal/length symbol that ends a block
+const int LZ77_LITLEN_SYMBOLS = 286;      // 256 literals, end of block, 29 length codes
+const int LZ77_DISTANCE_SYMBOLS = 30;
+const int LZ77_MIN_LEVEL = 1;
+const int LZ77_MAX_LEVEL = 9;
+const int LZ77_DEFAULT_LEVEL = 6;
+
+/*
+ * Compresses the input. Higher levels search longer hash chains and look one byte ahead for a
+ * better match before taking one (levels 4 and up), trading speed for smaller output; level 1 is
+ * the fastest. Decompression speed is about the same at every level.
+ */
+void compressLZ77(istream& input, obitstream& output, int level = LZ77_DEFAULT_LEVEL);
+
+/*
+ * Decompresses a stream written by compressLZ77. Throws an error if the data is not in the
+ * LZ77 format or is damaged.
+ */
+void decompressLZ77(ibitstream& input, ostream& output);
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the in-memory codec declared in memorycodec.h. compress codes
+ * the input a block at a time straight from the caller's bytes, with one reused scratch string for
+ * the block being encoded. decompress first walks the block headers to find the decoded size, so
+ * the output is sized once, and then decodes each block in place at the end of the output.
+ */
+
+#include "memorycodec.h"
+#include <algorithm>
+#include <cstring>
+#include "error.h"
+
+OutputBuffer::OutputBuffer() {
+    myData = NULL;
+    mySize = 0;
+    myCapacity = 0;
+    myOwned = true;
+}
+
+OutputBuffer::OutputBuffer(unsigned char* memory, size_t capacity) {
+    myData = memory;
+    mySize = 0;
+    myCapacity = capacity;
+    myOwned = false;
+}
+
+OutputBuffer::~OutputBuffer() {
+    if (myOwned) delete[] myData;
+}
+
+unsigned char* OutputBuffer::data() {
+    return myData;
+}
+
+const unsigned char* OutputBuffer::data() const {
+    return myData;
+}
+
+size_t OutputBuffer::size() const {
+    return mySize;
+}
+
+size_t OutputBuffer::capacity() const {
+    return myCapacity;
+}
+
+bool OutputBuffer::owned() const {
+    return myOwned;
+}
+
+/*
+ * An owned buffer at least doubles when it grows, so a run of appends costs O(1) each on average.
+ * Big-Oh: O(N) when it grows, O(1) otherwise
+ * @capacity: the number of bytes needed in all
+ */
+void OutputBuffer::reserve(size_t capacity) {
+    if (capacity <= myCapacity) return;
+    if (!myOwned) error("OutputBuffer: output does not fit in the buffer");
+    size_t newCapacity = max(capacity, 2 * myCapacity);
+    unsigned char* newData = new unsigned char[newCapacity];
+    if (mySize > 0) memcpy(newData, myData, mySize);
+    delete[] myData;
+    myData = newData;
+    myCapacity = newCapacity;
+}
+
+unsigned char* OutputBuffer::extend(size_t count) {
+    if (count > SIZE_MAX - mySize) error("OutputBuffer: output does not fit in the buffer");
+    reserve(mySize + count);
+    unsigned char* p = myData + mySize;
+    mySize += count;
+    return p;
+}
+
+void OutputBuffer::append(const void* bytes, size_t count) {
+    if (count > 0) memcpy(extend(count), bytes, count);
+}
+
+void OutputBuffer::truncate(size_t size) {
+    if (size < mySize) mySize = size;
+}
+
+void OutputBuffer::clear() {
+    mySize = 0;
+}
+
+string OutputBuffer::str() const {
+    return string((const char*) myData, mySize);
+}
+
+/*
+ * Every block's payload is at most its length plus a checksum (a block that coding would not
+ * shrink is stored raw), and the rest is headers, the end marker and the index.
+ */
+size_t compressBound(size_t length, const BlockOptions& options) {
+    if (options.blockSize < 1) error("compressBound: invalid block size");
+    size_t numBlocks = length / options.blockSize + (length % options.blockSize != 0);
+    size_t bound = STREAM_HEADER_BYTES + numBlocks * (BLOCK_HEADER_BYTES + BLOCK_CHECKSUM_BYTES) + length
+            + BLOCK_HEADER_BYTES;
+    if (options.indexed) bound += (numBlocks + 1) * INDEX_ENTRY_BYTES + INDEX_TRAILER_BYTES;
+    return bound;
+}
+
+/*
+ * Writes the same stream as compressBlocks: header, blocks, end marker and (if asked for) index.
+ * Only an owned buffer is reserved up front: the bound is a worst case, and caller memory that
+ * holds the real output is enough.
+ * @data: the input
+ * @length: its number of bytes
+ * @output: where the stream is appended
+ * @options: the compression settings
+ */
+void compress(const unsigned char* data, size_t length, OutputBuffer& output, const BlockOptions& options) {
+    string encoded;
+    writeStreamHeader(encoded, options);
+    if (output.owned()) output.reserve(output.size() + compressBound(length, options));
+    size_t start = output.size();
+    try {
+        output.append(encoded.data(), encoded.size());
+        Vector<BlockIndexEntry> index;
+        BlockIndexEntry position = {STREAM_HEADER_BYTES, 0};
+        for (size_t done = 0; done < length; done += options.blockSize) {
+            size_t blockLength = min(length - done, (size_t) options.blockSize);
+            encoded.clear();
+            encodeBlock(data + done, blockLength, options, encoded);
+            output.append(encoded.data(), encoded.size());
+            if (options.indexed) index.add(position);
+            position.compressedOffset += encoded.size();
+            position.rawOffset += blockLength;
+        }
+        encoded.clear();
+        appendEndBlock(encoded);
+        if (options.indexed) {
+            index.add(position);
+            appendBlockIndex(encoded, index, position.compressedOffset + BLOCK_HEADER_BYTES);
+        }
+        output.append(encoded.data(), encoded.size());
+    } catch (...) {
+        output.truncate(start); //don't leave part of a stream behind
+        throw;
+    }
+}
+
+/*
+ * Checks the layout of a stream: its header, block headers whose blocks fit in the block size and
+ * in the data, the end marker, and nothing after it but the index (if the stream has one).
+ * Calls visit(header, payload) on every block and returns the total decoded size.
+ */
+template <typename Visit>
+static uint64_t walkBlocks(const unsigned char* data, size_t length, Visit visit) {
+    if (length < (size_t) STREAM_HEADER_BYTES) error("decompress: not a block-compressed stream");
+    BlockOptions options;
+    parseStreamHeader(data, options);
+    const unsigned char* p = data + STREAM_HEADER_BYTES;
+    size_t remaining = length - STREAM_HEADER_BYTES;
+    uint64_t total = 0;
+    size_t numBlocks = 0;
+    while (true) {
+        if (remaining < (size_t) BLOCK_HEADER_BYTES) error("decompress: compressed data is truncated");
+        BlockHeader header;
+        parseBlockHeader(p, header);
+        p += BLOCK_HEADER_BYTES;
+        remaining -= BLOCK_HEADER_BYTES;
+        if (header.type == BLOCK_END) break;
+        if (header.rawLength > (uint32_t) options.blockSize || header.payloadLength > remaining
+                || (options.checksummed && !(header.type & BLOCK_FLAG_CHECKSUM))) {
+            error("decompress: block header is corrupt");
+        }
+        visit(header, p);
+        total += header.rawLength;
+        p += header.payloadLength;
+        remaining -= header.payloadLength;
+        numBlocks++;
+    }
+    size_t indexBytes = options.indexed ? (numBlocks + 1) * INDEX_ENTRY_BYTES + INDEX_TRAILER_BYTES : 0;
+    if (remaining != indexBytes) error("decompress: unexpected data after the compressed stream");
+    return total;
+}
+
+uint64_t decompressedSize(const unsigned char* data, size_t length) {
+    return walkBlocks(data, length, [](const BlockHeader&, const unsigned char*) {});
+}
+
+/*
+ * Two passes over the headers: one to size the output, one to decode. The first also checks the
+ * whole layout, so a truncated stream is reported before anything is decoded. A block that fails
+ * to decode leaves output as it was on entry.
+ * @data: the compressed stream
+ * @length: its number of bytes
+ * @output: where the decoded bytes are appended
+ */
+void decompress(const unsigned char* data, size_t length, OutputBuffer& output) {
+    uint64_t size = decompressedSize(data, length);
+    if (size > (uint64_t) (SIZE_MAX - output.size())) error("decompress: output does not fit in memory");
+    output.reserve(output.size() + (size_t) size);
+    size_t start = output.size();
+    try {
+        walkBlocks(data, length, [&](const BlockHeader& header, const unsigned char* payload) {
+            decodeBlock(header, payload, output.extend(header.rawLength));
+        });
+    } catch (...) {
+        output.truncate(start); //drop the damaged block and any decoded before it
+        throw;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the memorycodec.h file which declares compress and decompress for data that is already
+ * in memory. The stream functions need an istream and an obitstream, so a caller holding a buffer
+ * has to copy it into an istringstream and copy the result back out of an ostringbitstream. These
+ * work on byte ranges instead: the input is coded where it lies, and the output goes straight into
+ * an OutputBuffer, which is either the caller's own memory or a buffer that grows as needed.
+ *
+ * The data is in the block format (blockcodec.h), byte for byte what compressBlocks writes with the
+ * same options, so either side can be swapped for the stream functions or the command line.
+ */
+
+#ifndef _memorycodec_h
+#define _memorycodec_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "blockcodec.h"
+using namespace std;
+
+/*
+ * Where compress and decompress put their output. Data is always added at the end, after
+ * whatever is already there.
+ */
+class OutputBuffer {
+public:
+    /*
+     * Constructs an empty buffer that allocates its own memory and grows as needed.
+     */
+    OutputBuffer();
+
+    /*
+     * Constructs an empty buffer over capacity bytes of the caller's memory, which must outlive
+     * it. It never allocates: writing more than fits throws an error.
+     */
+    OutputBuffer(unsigned char* memory, size_t capacity);
+
+    ~OutputBuffer();
+
+    unsigned char* data();
+    const unsigned char* data() const;
+    size_t size() const;
+    size_t capacity() const;
+
+    /*
+     * Returns true if the buffer allocates its own memory, false if it is the caller's.
+     */
+    bool owned() const;
+
+    /*
+     * Makes room for at least capacity bytes in all (not counting the ones already there).
+     * Throws an error if the buffer is the caller's memory and that is too small.
+     */
+    void reserve(size_t capacity);
+
+    /*
+     * Adds count bytes to the end and returns a pointer to them, for the caller to fill in.
+     */
+    unsigned char* extend(size_t count);
+
+    void append(const void* bytes, size_t count);
+
+    /*
+     * Drops bytes from the end so that size remain (if there are more than that).
+     */
+    void truncate(size_t size);
+
+    /*
+     * Empties the buffer, keeping its memory.
+     */
+    void clear();
+
+    /*
+     * Returns a copy of the contents.
+     */
+    string str() const;
+
+private:
+    OutputBuffer(const OutputBuffer& other);            // not copyable (may own its memory)
+    OutputBuffer& operator =(const OutputBuffer& other);
+
+    unsigned char* myData;
+    size_t mySize; //number of bytes in use
+    size_t myCapacity; //actual size of myData
+    bool myOwned; //whether myData is ours to grow and free
+};
+
+/*
+ * Returns the largest number of bytes compress can write for length bytes of input, so a caller
+ * can size its buffer once. Blocks that coding would not shrink are stored as they are, so this is
+ * barely more than length.
+ */
+size_t compressBound(size_t length, const BlockOptions& options = BlockOptions());
+
+/*
+ * Compresses length bytes of data and appends the compressed stream to output. An owned
+ * OutputBuffer is grown to compressBound up front, so it is never copied while the stream is
+ * written. Caller memory only needs room for the actual compressed stream; if it runs out, this
+ * throws an error and output is left as it was.
+ */
+void compress(const unsigned char* data, size_t length, OutputBuffer& output,
+              const BlockOptions& options = BlockOptions());
+
+/*
+ * Returns the number of bytes a compressed stream decodes to, read from its block headers without
+ * decoding anything. Throws an error if the data is not a complete stream in the block format.
+ */
+uint64_t decompressedSize(const unsigned char* data, size_t length);
+
+/*
+ * Decompresses a stream written by compress (or compressBlocks) and appends the decoded bytes to
+ * output. Every block is decoded straight into the buffer, which is first made big enough for all
+ * of them. Throws an error if the data is not in the block format or is damaged, leaving output
+ * as it was.
+ */
+void decompress(const unsigned char* data, size_t length, OutputBuffer& output);
+
+#endif
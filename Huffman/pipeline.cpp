@@ -0,0 +1,253 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the pipelined drivers declared in pipeline.h. The reader hands
+ * every block to two queues: the work queue, which the workers take jobs from in any order, and the
+ * order queue, which the writer takes them from in the order they were read. Each job carries a
+ * future that its worker completes (or fails with the worker's exception), so the writer simply
+ * waits on the oldest job. A failure in any stage closes both queues, which releases every thread
+ * blocked on them, and the error is rethrown on the calling thread once all the threads are joined.
+ */
+
+#include "pipeline.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "error.h"
+#include "vector.h"
+
+/*
+ * A first-in first-out queue that holds at most capacity items. push waits while it is full and
+ * pop waits while it is empty; once it is closed, push fails and pop fails as soon as it is empty.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(size_t capacity) {
+        myCapacity = capacity;
+        myClosed = false;
+    }
+
+    /*
+     * Adds item at the back, returning false (without adding it) if the queue is closed.
+     */
+    bool push(const T& item) {
+        unique_lock<mutex> lock(myMutex);
+        myNotFull.wait(lock, [this]() { return myClosed || myItems.size() < myCapacity; });
+        if (myClosed) return false;
+        myItems.push_back(item);
+        myNotEmpty.notify_one();
+        return true;
+    }
+
+    /*
+     * Removes the front item into item, returning false if the queue is closed and empty.
+     */
+    bool pop(T& item) {
+        unique_lock<mutex> lock(myMutex);
+        myNotEmpty.wait(lock, [this]() { return myClosed || !myItems.empty(); });
+        if (myItems.empty()) return false;
+        item = myItems.front();
+        myItems.pop_front();
+        myNotFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(myMutex);
+        myClosed = true;
+        myNotFull.notify_all();
+        myNotEmpty.notify_all();
+    }
+
+private:
+    BoundedQueue(const BoundedQueue& other);            // not copyable (owns a mutex)
+    BoundedQueue& operator =(const BoundedQueue& other);
+
+    mutex myMutex;
+    condition_variable myNotFull;
+    condition_variable myNotEmpty;
+    deque<T> myItems;
+    size_t myCapacity;
+    bool myClosed;
+};
+
+/*
+ * One block on its way through the pipeline.
+ */
+struct PipelineJob {
+    string input;          // the block's bytes (compressing) or its payload (decompressing)
+    BlockHeader header;    // decompressing only: the block's header
+    string output;         // the encoded block (compressing) or its decoded bytes (decompressing)
+    promise<void> done;    // completed by the worker, or failed with its exception
+    future<void> result;   // the writer waits on this
+};
+
+typedef shared_ptr<PipelineJob> JobPointer;
+
+PipelineOptions::PipelineOptions() {
+    numWorkers = max(1, (int) thread::hardware_concurrency());
+    maxInFlight = 2 * numWorkers;
+}
+
+/*
+ * Runs the three stages until read returns false, then joins every thread.
+ * @read: fills in the next job's input on the reader thread; returns false at the end of the input
+ * @work: turns a job's input into its output on a worker thread
+ * @write: writes a finished job on the writer thread, in the order the jobs were read
+ */
+static void runPipeline(const PipelineOptions& options, const function<bool(PipelineJob&)>& read,
+                        const function<void(PipelineJob&)>& work, const function<void(PipelineJob&)>& write) {
+    if (options.numWorkers < 1 || options.maxInFlight < 1) {
+        error("PipelineOptions: need at least one worker and one block in flight");
+    }
+    BoundedQueue<JobPointer> workQueue(options.maxInFlight);
+    BoundedQueue<JobPointer> orderQueue(options.maxInFlight);
+    exception_ptr readError;
+    exception_ptr writeError;
+
+    thread reader([&]() {
+        try {
+            while (true) {
+                JobPointer job(new PipelineJob);
+                job->result = job->done.get_future();
+                if (!read(*job)) break;
+                if (!orderQueue.push(job) || !workQueue.push(job)) break; //the writer gave up
+            }
+        } catch (...) {
+            readError = current_exception();
+        }
+        workQueue.close();
+        orderQueue.close();
+    });
+
+    Vector<thread*> workers;
+    for (int i = 0; i < options.numWorkers; i++) {
+        workers.add(new thread([&]() {
+            JobPointer job;
+            while (workQueue.pop(job)) {
+                try {
+                    work(*job);
+                    job->done.set_value();
+                } catch (...) {
+                    job->done.set_exception(current_exception());
+                }
+            }
+        }));
+    }
+
+    thread writer([&]() {
+        try {
+            JobPointer job;
+            while (orderQueue.pop(job)) {
+                job->result.get(); //rethrows the worker's exception
+                write(*job);
+            }
+        } catch (...) {
+            writeError = current_exception();
+            workQueue.close();
+            orderQueue.close();
+        }
+    });
+
+    reader.join();
+    for (int i = 0; i < workers.size(); i++) {
+        workers[i]->join();
+        delete workers[i];
+    }
+    writer.join();
+    if (writeError) rethrow_exception(writeError); //the earliest block that went wrong
+    if (readError) rethrow_exception(readError);
+}
+
+/*
+ * The reader cuts the input into blocks, the workers encode them with encodeBlock, and the writer
+ * writes them and notes their offsets for the index, which is written at the end.
+ * @input: where the data is being encoded from
+ * @output: where the encoded data is being written to
+ * @blockOptions: the compression settings
+ * @options: the number of threads and blocks in flight
+ */
+void compressBlocksPipelined(istream& input, ostream& output, const BlockOptions& blockOptions,
+                             const PipelineOptions& options) {
+    string encoded;
+    writeStreamHeader(encoded, blockOptions);
+    output.write(encoded.data(), encoded.size());
+    Vector<BlockIndexEntry> index;
+    BlockIndexEntry position = {STREAM_HEADER_BYTES, 0};
+    bool atEnd = false;
+
+    runPipeline(options,
+        [&](PipelineJob& job) {
+            if (atEnd) return false;
+            job.input.resize(blockOptions.blockSize);
+            input.read(&job.input[0], blockOptions.blockSize);
+            job.input.resize((size_t) input.gcount());
+            atEnd = job.input.size() < (size_t) blockOptions.blockSize;
+            return !job.input.empty();
+        },
+        [&](PipelineJob& job) {
+            encodeBlock((const unsigned char*) job.input.data(), job.input.size(), blockOptions, job.output);
+        },
+        [&](PipelineJob& job) {
+            output.write(job.output.data(), job.output.size());
+            if (!output) error("compressBlocksPipelined: could not write the output");
+            if (blockOptions.indexed) index.add(position);
+            position.compressedOffset += job.output.size();
+            position.rawOffset += job.input.size();
+        });
+
+    encoded.clear();
+    appendEndBlock(encoded);
+    if (blockOptions.indexed) {
+        index.add(position);
+        appendBlockIndex(encoded, index, position.compressedOffset + BLOCK_HEADER_BYTES);
+    }
+    output.write(encoded.data(), encoded.size());
+    output.flush();
+}
+
+/*
+ * The reader reads block headers and payloads up to the end marker, the workers decode them with
+ * decodeBlock, and the writer writes the decoded bytes. Raw blocks are passed through as they are.
+ * @input: where the encoded data is being read from
+ * @output: where the decoded data is being written to
+ * @options: the number of threads and blocks in flight
+ */
+void decompressBlocksPipelined(istream& input, ostream& output, const PipelineOptions& options) {
+    BlockOptions blockOptions;
+    readStreamHeader(input, blockOptions);
+
+    runPipeline(options,
+        [&](PipelineJob& job) {
+            if (!readBlockHeader(input, job.header)) return false;
+            if (job.header.rawLength > (uint32_t) blockOptions.blockSize
+                    || job.header.payloadLength > (uint32_t) MAX_BLOCK_SIZE * 2
+                    || (blockOptions.checksummed && !(job.header.type & BLOCK_FLAG_CHECKSUM))) {
+                error("decompressBlocksPipelined: block header is corrupt");
+            }
+            job.input.resize(job.header.payloadLength);
+            input.read(&job.input[0], job.header.payloadLength);
+            if ((size_t) input.gcount() != job.header.payloadLength) {
+                error("decompressBlocksPipelined: compressed stream is truncated");
+            }
+            return true;
+        },
+        [&](PipelineJob& job) {
+            if (job.header.type == BLOCK_RAW && job.header.payloadLength == job.header.rawLength) {
+                job.output.swap(job.input); //already the decoded bytes
+                return;
+            }
+            job.output.resize(job.header.rawLength);
+            decodeBlock(job.header, (const unsigned char*) job.input.data(), (unsigned char*) &job.output[0]);
+        },
+        [&](PipelineJob& job) {
+            output.write(job.output.data(), job.output.size());
+            if (!output) error("decompressBlocksPipelined: could not write the output");
+        });
+    output.flush();
+}
@@ -0,0 +1,43 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the pipeline.h file which declares multi-threaded drivers for the block format
+ * (blockcodec.h). compressBlocks and decompressBlocks read a block, code it and write it on one
+ * thread, so the CPU sits idle while the disk works and the disk sits idle while the CPU works.
+ * These drivers split that into three stages: a reader thread that fills block buffers, a pool of
+ * worker threads that encode or decode them, and a writer thread that writes the results in their
+ * original order. Bounded queues between the stages limit how many blocks are in memory at once,
+ * so a slow writer holds the reader back instead of letting blocks pile up.
+ *
+ * The output is byte for byte the same as compressBlocks/decompressBlocks with the same options.
+ */
+
+#ifndef _pipeline_h
+#define _pipeline_h
+
+#include <iostream>
+#include "blockcodec.h"
+using namespace std;
+
+/*
+ * Settings for the pipelined drivers. The defaults use every hardware thread.
+ */
+struct PipelineOptions {
+    int numWorkers;    // threads encoding or decoding blocks
+    int maxInFlight;   // most blocks read but not yet written; bounds memory to about twice this many blocks
+    PipelineOptions();
+};
+
+/*
+ * Compresses the input into the block format like compressBlocks, with the stages overlapped.
+ */
+void compressBlocksPipelined(istream& input, ostream& output, const BlockOptions& blockOptions = BlockOptions(),
+                             const PipelineOptions& options = PipelineOptions());
+
+/*
+ * Decompresses a block-format stream like decompressBlocks, with the stages overlapped. Throws an
+ * error if the data is not in the block format or is damaged; output written before the damaged
+ * block is found stays written.
+ */
+void decompressBlocksPipelined(istream& input, ostream& output, const PipelineOptions& options = PipelineOptions());
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the static tables declared in statictables.h. Each table's
+ * code bits and decode table are built once, when it is registered (the built-in ones on first
+ * use), and kept in a registry indexed by ID. Registry slots are atomic pointers that are only
+ * ever filled in, never changed, so looking a table up takes no lock. Coding a message is then
+ * a BitWriter loop over the stored codes, and decoding is decodeBitStream from the block format.
+ */
+
+#include "statictables.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "blockcodec.h"
+#include "bytes.h"
+#include "error.h"
+#include "huffmancode.h"
+#include "strlib.h"
+
+/*
+ * The built-in STATIC_TABLE_TEXT, made by the trainer (11-bit limit) from the block comments of
+ * this directory's sources, about 64 KB of English prose.
+ */
+static const unsigned char TEXT_TABLE[256] = {
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 6, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    3, 11, 10, 11, 11, 11, 11, 9, 9, 9, 11, 11, 7, 9, 7, 11,
+    10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 10, 10, 11, 11, 11, 11,
+    11, 9, 9, 10, 10, 9, 10, 11, 10, 10, 11, 11, 9, 10, 10, 10,
+    11, 11, 9, 9, 8, 11, 11, 10, 11, 11, 11, 11, 11, 11, 11, 10,
+    11, 4, 6, 5, 5, 3, 6, 7, 5, 5, 11, 8, 5, 6, 5, 4,
+    6, 10, 5, 4, 4, 6, 8, 7, 9, 7, 10, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11
+};
+
+/*
+ * A registered table, ready to code with.
+ */
+struct StaticTable {
+    int lengths[256];
+    uint32_t bits[256];
+    HuffmanDecodeTable decodeTable;
+};
+
+static atomic<StaticTable*> registry[MAX_STATIC_TABLES];
+static mutex registryLock; //serializes registration; lookups don't take it
+
+/*
+ * Builds a table from lengths and puts it in the registry.
+ * Throws an error if the lengths don't give every byte value a code of at most
+ * MAX_BLOCK_CODE_LENGTH bits, or don't form a complete code.
+ */
+static void addTable(int id, const int lengths[256]) {
+    uint32_t kraft = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        if (lengths[ch] < 1 || lengths[ch] > MAX_BLOCK_CODE_LENGTH) {
+            error("registerStaticTable: every byte value needs a code of 1 to " + integerToString(MAX_BLOCK_CODE_LENGTH) + " bits");
+        }
+        kraft += 1u << (MAX_BLOCK_CODE_LENGTH - lengths[ch]);
+    }
+    if (kraft != 1u << MAX_BLOCK_CODE_LENGTH) error("registerStaticTable: code lengths are not a complete code");
+    StaticTable* table = new StaticTable;
+    HuffmanCode code;
+    code.build(lengths, 256);
+    for (int ch = 0; ch < 256; ch++) {
+        table->lengths[ch] = lengths[ch];
+        table->bits[ch] = code.bits(ch);
+    }
+    table->decodeTable.build(code);
+    lock_guard<mutex> lock(registryLock);
+    if (registry[id].load() != NULL) {
+        delete table;
+        error("registerStaticTable: table " + integerToString(id) + " is already registered");
+    }
+    registry[id].store(table);
+}
+
+/*
+ * Registers the built-in tables the first time it is called (C++11 runs a function-local static's
+ * initializer exactly once, even with several threads calling).
+ */
+static bool registerBuiltInTables() {
+    int lengths[256];
+    for (int ch = 0; ch < 256; ch++) {
+        lengths[ch] = TEXT_TABLE[ch];
+    }
+    addTable(STATIC_TABLE_TEXT, lengths);
+    return true;
+}
+
+/*
+ * Returns the table with the given ID, or NULL if there is none.
+ */
+static const StaticTable* findTable(int id) {
+    static bool builtIn = registerBuiltInTables();
+    (void) builtIn;
+    if (id < 0 || id >= MAX_STATIC_TABLES) return NULL;
+    return registry[id].load();
+}
+
+/*
+ * Counts the samples' bytes, adds one to every count so that unseen bytes still get a (long)
+ * code, and builds length-limited code lengths from the counts.
+ */
+void trainStaticTable(const Vector<string>& samples, int maxCodeLength, int lengths[256]) {
+    if (maxCodeLength < 8 || maxCodeLength > MAX_BLOCK_CODE_LENGTH) {
+        error("trainStaticTable: max code length must be between 8 and " + integerToString(MAX_BLOCK_CODE_LENGTH));
+    }
+    uint64_t counts[256];
+    for (int ch = 0; ch < 256; ch++) {
+        counts[ch] = 1;
+    }
+    for (int i = 0; i < samples.size(); i++) {
+        for (unsigned char ch : samples[i]) {
+            counts[ch]++;
+        }
+    }
+    HuffmanPool pool;
+    pool.build(counts, 256);
+    pool.codeLengths(lengths, 256, maxCodeLength);
+}
+
+void writeStaticTableSource(ostream& output, const string& name, const int lengths[256]) {
+    output << "static const unsigned char " << name << "[256] = {";
+    for (int ch = 0; ch < 256; ch++) {
+        if (ch % 16 == 0) output << endl << "    ";
+        output << lengths[ch] << (ch < 255 ? (ch % 16 == 15 ? "," : ", ") : "");
+    }
+    output << endl << "};" << endl;
+}
+
+void registerStaticTable(int id, const int lengths[256]) {
+    findTable(STATIC_TABLE_NONE); //makes sure the built-in tables are in place first
+    if (id < FIRST_USER_STATIC_TABLE || id >= MAX_STATIC_TABLES) {
+        error("registerStaticTable: table IDs must be between " + integerToString(FIRST_USER_STATIC_TABLE)
+              + " and " + integerToString(MAX_STATIC_TABLES - 1));
+    }
+    addTable(id, lengths);
+}
+
+bool hasStaticTable(int id) {
+    return id == STATIC_TABLE_NONE || findTable(id) != NULL;
+}
+
+/*
+ * Works out the coded size from the code lengths first, so a message the table would not shrink
+ * goes straight to STATIC_TABLE_NONE without being coded.
+ * @data: the message
+ * @length: its number of bytes
+ * @tableId: the table to code it with
+ * @output: where the coded message is appended
+ */
+void compressStatic(const unsigned char* data, size_t length, int tableId, string& output) {
+    const StaticTable* table = findTable(tableId);
+    if (table == NULL && tableId != STATIC_TABLE_NONE) {
+        error("compressStatic: no static table " + integerToString(tableId));
+    }
+    uint64_t bits = 0;
+    if (table != NULL) {
+        for (size_t i = 0; i < length; i++) {
+            bits += table->lengths[data[i]];
+        }
+    }
+    if (table == NULL || (bits + 7) / 8 >= length) {
+        output += (char) STATIC_TABLE_NONE;
+        appendVarint(output, length);
+        output.append((const char*) data, length);
+        return;
+    }
+    output += (char) tableId;
+    appendVarint(output, length);
+    BitWriter writer(output);
+    for (size_t i = 0; i < length; i++) {
+        writer.writeBits(table->bits[data[i]], table->lengths[data[i]]);
+    }
+    writer.flush();
+}
+
+string compressStatic(const string& message, int tableId) {
+    string output;
+    compressStatic((const unsigned char*) message.data(), message.size(), tableId, output);
+    return output;
+}
+
+/*
+ * Reads the table ID and length, then copies or decodes the message. A coded message's bit
+ * stream is as long as its codes need, rounded up to a byte, which is found from the decoded
+ * bytes' code lengths once they are decoded.
+ * @data: the start of the message
+ * @length: the number of bytes available from data on (may include later messages)
+ * @output: where the decoded message goes
+ */
+size_t decompressStatic(const unsigned char* data, size_t length, string& output) {
+    if (length < 1) error("decompressStatic: message is truncated");
+    const unsigned char* p = data + 1;
+    const unsigned char* end = data + length;
+    uint64_t messageLength;
+    if (!readVarint(p, end, messageLength)) error("decompressStatic: message is truncated");
+    int tableId = data[0];
+    const StaticTable* table = findTable(tableId);
+    if (table == NULL && tableId != STATIC_TABLE_NONE) {
+        error("decompressStatic: no static table " + integerToString(tableId));
+    }
+    size_t available = end - p;
+    if (table == NULL) {
+        if (messageLength > available) error("decompressStatic: message is truncated");
+        output.assign((const char*) p, (size_t) messageLength);
+        return p + messageLength - data;
+    }
+    if (messageLength / 8 > available) error("decompressStatic: message is truncated"); //codes are at least 1 bit
+    output.resize((size_t) messageLength);
+    if (messageLength == 0) return p - data;
+    unsigned char* out = (unsigned char*) &output[0];
+    decodeBitStream(table->decodeTable, p, available, out, output.size());
+    uint64_t bits = 0;
+    for (size_t i = 0; i < output.size(); i++) {
+        bits += table->lengths[out[i]];
+    }
+    if ((bits + 7) / 8 > available) error("decompressStatic: message is truncated");
+    return p + (bits + 7) / 8 - data;
+}
+
+string decompressStatic(const string& compressed) {
+    string output;
+    size_t used = decompressStatic((const unsigned char*) compressed.data(), compressed.size(), output);
+    if (used != compressed.size()) error("decompressStatic: unexpected data after the message");
+    return output;
+}
+
+#ifdef HUFFMAN_TRAIN_MAIN
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " NAME SAMPLE_FILE..." << endl;
+        return 2;
+    }
+    Vector<string> samples;
+    for (int i = 2; i < argc; i++) {
+        ifstream input(argv[i], ifstream::binary);
+        if (!input) {
+            cerr << argv[0] << ": cannot read " << argv[i] << endl;
+            return 1;
+        }
+        ostringstream contents;
+        contents << input.rdbuf();
+        samples.add(contents.str());
+    }
+    int lengths[256];
+    trainStaticTable(samples, DEFAULT_BLOCK_CODE_LENGTH, lengths);
+    writeStaticTableSource(cout, argv[1], lengths);
+    return 0;
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the statictables.h file which declares static Huffman tables for small messages.
+ * compress puts a frequency table in front of every message, and for a message of a few hundred
+ * bytes that header costs more than coding saves. A static table is trained once, offline, on
+ * a sample of the messages, compiled into the program (or registered at startup) under a numeric
+ * ID, and shared by both ends, so a message carries only the table's ID and its length, and
+ * neither end builds a code at run time.
+ *
+ * Message layout: table ID (byte), message length (variable-length integer, see bytes.h), then
+ * the message's codes as one byte-aligned bit stream. With STATIC_TABLE_NONE the message's bytes
+ * follow as they are; compressStatic falls back to it when the table would not shrink a message.
+ *
+ * Training: trainStaticTable turns sample messages into code lengths, and
+ * writeStaticTableSource prints them as a C++ array to paste into statictables.cpp (or pass to
+ * registerStaticTable). Building statictables.cpp with HUFFMAN_TRAIN_MAIN defined gives a
+ * program that does both: trainer NAME SAMPLE_FILE... prints a table trained on the files.
+ */
+
+#ifndef _statictables_h
+#define _statictables_h
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "vector.h"
+using namespace std;
+
+const int STATIC_TABLE_NONE = 0;          // the message is stored as it is
+const int STATIC_TABLE_TEXT = 1;          // built in: English prose and ASCII text
+const int FIRST_USER_STATIC_TABLE = 128;  // IDs from here up are for registerStaticTable
+const int MAX_STATIC_TABLES = 256;        // IDs are one byte
+
+/*
+ * Computes code lengths (at most maxCodeLength bits, 8 to 15) from the byte counts of the
+ * samples. Every byte value gets a code, so the table can code any message, not just ones
+ * like the samples.
+ */
+void trainStaticTable(const Vector<string>& samples, int maxCodeLength, int lengths[256]);
+
+/*
+ * Writes lengths as a C++ array definition named name.
+ */
+void writeStaticTableSource(ostream& output, const string& name, const int lengths[256]);
+
+/*
+ * Makes a table available under an ID from FIRST_USER_STATIC_TABLE up. Its codes are built here,
+ * once. Both ends must register the same lengths under the same ID, before any other thread uses
+ * that ID. Throws an error if the ID is out of range or already taken, or the lengths are not a
+ * complete code covering every byte value within 15 bits.
+ */
+void registerStaticTable(int id, const int lengths[256]);
+
+/*
+ * Returns true if a table with this ID exists (built in or registered).
+ */
+bool hasStaticTable(int id);
+
+/*
+ * Appends the message coded with table tableId (or stored, if that is smaller) to output.
+ * Throws an error if there is no such table.
+ */
+void compressStatic(const unsigned char* data, size_t length, int tableId, string& output);
+string compressStatic(const string& message, int tableId);
+
+/*
+ * Decodes one message starting at data into output (replacing its contents) and returns the
+ * number of bytes it took, so messages can be packed back to back. Throws an error if the
+ * message names an unknown table or is damaged.
+ */
+size_t decompressStatic(const unsigned char* data, size_t length, string& output);
+string decompressStatic(const string& compressed);
+
+#endif
@@ -0,0 +1,365 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the tANS coder declared in tans.h. The table has 2^tableLog
+ * slots shared out between the characters in proportion to their normalized counts and spread
+ * evenly over the table. A coder state is a slot number; decoding a character is one table lookup
+ * giving the character, how many bits to read and the base of the next state. Four states take turns
+ * (position i uses state i % 4), so the decoder's four lookup chains can overlap like the four
+ * Huffman streams of a BLOCK_HUFFMAN_X4 block.
+ */
+
+#include "tans.h"
+#include <cstring>
+#include "BitIO.h"
+#include "bytes.h"
+#include "error.h"
+
+static const int NUM_STATES = 4;
+
+/*
+ * Returns the position of the highest set bit of value (which must not be 0).
+ */
+static int highestBit(uint32_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+/*
+ * Gives the characters to the table slots: each character's slots are spread over the table with
+ * a step that is coprime to its size, so every slot is visited exactly once.
+ */
+static void spreadSymbols(const int normalized[256], int tableLog, unsigned char spread[]) {
+    int tableSize = 1 << tableLog;
+    int step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    int position = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        for (int i = 0; i < normalized[ch]; i++) {
+            spread[position] = (unsigned char) ch;
+            position = (position + step) & (tableSize - 1);
+        }
+    }
+}
+
+/*
+ * Rounds each count to its share of the table, then nudges the total to exactly the table size
+ * one slot at a time, each time picking the character whose cost changes least (about count / slots).
+ */
+void normalizeCounts(const uint64_t counts[256], size_t total, int tableLog, int normalized[256]) {
+    int tableSize = 1 << tableLog;
+    int sum = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        normalized[ch] = 0;
+        if (counts[ch] == 0) continue;
+        normalized[ch] = max(1, (int) ((double) counts[ch] * tableSize / total + 0.5));
+        sum += normalized[ch];
+    }
+    while (sum != tableSize) {
+        int best = -1;
+        double bestScore = 0;
+        for (int ch = 0; ch < 256; ch++) {
+            if (normalized[ch] == 0 || (sum > tableSize && normalized[ch] == 1)) continue;
+            double score = (double) counts[ch] / normalized[ch];
+            if (best < 0 || (sum < tableSize ? score > bestScore : score < bestScore)) {
+                best = ch;
+                bestScore = score;
+            }
+        }
+        if (best < 0) error("normalizeCounts: table is too small for the number of characters");
+        if (sum < tableSize) {
+            normalized[best]++;
+            sum++;
+        } else {
+            normalized[best]--;
+            sum--;
+        }
+    }
+}
+
+/*
+ * Appends a character's normalized count: one byte under 128, otherwise two.
+ */
+static void writeCount(string& output, int count) {
+    if (count < 0x80) {
+        output += (char) count;
+    } else {
+        output += (char) (0x80 | (count & 0x7f));
+        output += (char) (count >> 7);
+    }
+}
+
+/*
+ * Encodes the data last character first, so that the decoder, reading the bits back in reverse,
+ * gets the characters in order. For a character with normalized count f, the state x (kept in
+ * [tableSize, 2 * tableSize)) sheds just enough low bits to land in [f, 2f), which then picks one
+ * of the character's f slots as the new state.
+ * @data: the bytes to encode
+ * @length: the number of bytes
+ * @counts: the histogram of the bytes
+ * @output: where the encoding is appended
+ */
+void encodeTans(const unsigned char* data, size_t length, const uint64_t counts[256], string& output) {
+    int numSymbols = 0;
+    int lastSymbol = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        if (counts[ch] > 0) {
+            numSymbols++;
+            lastSymbol = ch;
+        }
+    }
+    int tableLog = TANS_DEFAULT_TABLE_LOG;
+    while (tableLog > TANS_MIN_TABLE_LOG && ((size_t) 1 << (tableLog - 1)) >= length) {
+        tableLog--; //a small input doesn't need a big table
+    }
+    while ((1 << tableLog) < 2 * numSymbols && tableLog < TANS_MAX_TABLE_LOG) {
+        tableLog++;
+    }
+    int tableSize = 1 << tableLog;
+    int normalized[256];
+    normalizeCounts(counts, length, tableLog, normalized);
+
+    output += (char) tableLog;
+    output += (char) lastSymbol;
+    for (int ch = 0; ch <= lastSymbol; ch++) {
+        writeCount(output, normalized[ch]);
+    }
+    size_t statesAt = output.size();
+    output.append(2 * NUM_STATES, '\0');
+
+    unsigned char* spread = new unsigned char[tableSize];
+    uint16_t* stateTable = new uint16_t[tableSize];
+    spreadSymbols(normalized, tableLog, spread);
+    int cumulative[256];
+    int next[256];
+    int total = 0;
+    for (int ch = 0; ch < 256; ch++) {
+        cumulative[ch] = total;
+        next[ch] = 0;
+        total += normalized[ch];
+    }
+    for (int slot = 0; slot < tableSize; slot++) {
+        int ch = spread[slot];
+        stateTable[cumulative[ch] + next[ch]++] = (uint16_t) (tableSize + slot);
+    }
+    int32_t findState[256];  //index into stateTable is (x >> bits) + findState[ch]
+    uint32_t deltaBits[256]; //bits to shed is (x + deltaBits[ch]) >> 16
+    for (int ch = 0; ch < 256; ch++) {
+        int count = normalized[ch];
+        findState[ch] = cumulative[ch] - count;
+        if (count <= 1) {
+            deltaBits[ch] = ((uint32_t) tableLog << 16) - tableSize;
+        } else {
+            int maxBits = tableLog - highestBit(count - 1);
+            deltaBits[ch] = ((uint32_t) maxBits << 16) - ((uint32_t) count << maxBits);
+        }
+    }
+
+    uint32_t states[NUM_STATES];
+    for (int s = 0; s < NUM_STATES; s++) {
+        states[s] = (uint32_t) tableSize;
+    }
+    {
+        BitWriter writer(output);
+        for (size_t i = length; i-- > 0; ) {
+            uint32_t& x = states[i % NUM_STATES];
+            int ch = data[i];
+            int bits = (int) ((x + deltaBits[ch]) >> 16);
+            writer.writeBits(x & ((1u << bits) - 1), bits);
+            x = stateTable[(x >> bits) + findState[ch]];
+        }
+        writer.writeBit(1); //end marker, so the decoder can find the last real bit
+        writer.flush();
+    }
+    for (int s = 0; s < NUM_STATES; s++) {
+        unsigned char* p = (unsigned char*) &output[statesAt + 2 * s];
+        p[0] = (unsigned char) (states[s] - tableSize);
+        p[1] = (unsigned char) ((states[s] - tableSize) >> 8);
+    }
+    delete[] spread;
+    delete[] stateTable;
+}
+
+/*
+ * One decode table slot: the slot's character, how many bits to read, and what to add them to
+ * for the next state.
+ */
+struct TansDecodeEntry {
+    uint16_t nextBase;
+    unsigned char symbol;
+    unsigned char numBits;
+};
+
+/*
+ * Reads a bit stream backwards: the last bits written come out first. The 64-bit container holds
+ * the eight bytes ending at myNext, and myConsumed counts the bits already used from its top.
+ */
+class BackwardBitReader {
+public:
+    /*
+     * @limit: lowest address that may be loaded, at least 8 bytes before end
+     * @start: where the stream really starts (limit, or later if the stream was padded in front)
+     * @end: just past the stream's last byte, which must hold the end marker
+     */
+    BackwardBitReader(const unsigned char* limit, const unsigned char* start, const unsigned char* end) {
+        myLimit = limit;
+        myStart = start;
+        myNext = end - 8;
+        myContainer = readUint64(myNext);
+        myConsumed = 8 - highestBit(end[-1]); //zeros above the marker, and the marker itself
+    }
+
+    /*
+     * Moves the container back over the bytes already used. Returns true if it now has at least
+     * 57 unread bits, false near the start of the stream.
+     */
+    bool reload() {
+        int bytes = myConsumed >> 3;
+        if (myNext - myLimit >= bytes) {
+            myNext -= bytes;
+            myConsumed &= 7;
+            myContainer = readUint64(myNext);
+            return myConsumed <= 7 && myNext - myLimit >= 0;
+        }
+        bytes = (int) (myNext - myLimit);
+        myNext = myLimit;
+        myConsumed -= 8 * bytes;
+        myContainer = readUint64(myNext);
+        return false;
+    }
+
+    /*
+     * Reads count bits (0 to 32). The caller must make sure the container has them.
+     */
+    uint32_t read(int count) {
+        uint32_t bits = (uint32_t) (((myContainer << myConsumed) >> 1) >> (63 - count));
+        myConsumed += count;
+        return bits;
+    }
+
+    /*
+     * Reads count bits, or sets bad and returns 0 if the container doesn't have them.
+     */
+    uint32_t readChecked(int count, bool& bad) {
+        if (myConsumed + count > 64) {
+            bad = true;
+            return 0;
+        }
+        return myConsumed == 64 ? 0 : read(count);
+    }
+
+    /*
+     * Returns the number of real stream bits not read yet (negative if the reader went too far).
+     */
+    int64_t bitsLeft() const {
+        return (int64_t) (myNext - myStart) * 8 + 64 - myConsumed;
+    }
+
+private:
+    const unsigned char* myLimit;
+    const unsigned char* myStart;
+    const unsigned char* myNext;
+    uint64_t myContainer;
+    int myConsumed;
+};
+
+/*
+ * Rebuilds the table from the stored counts, then runs the four interleaved states forward
+ * (position i uses state i % 4). While the reader is far from the start of the stream, one reload
+ * covers four characters (at most 48 bits).
+ * @encoded: what encodeTans appended
+ * @encodedLength: its number of bytes
+ * @output: where the decoded bytes go
+ * @length: the number of bytes to decode
+ */
+void decodeTans(const unsigned char* encoded, size_t encodedLength, unsigned char* output, size_t length) {
+    const unsigned char* p = encoded;
+    const unsigned char* end = encoded + encodedLength;
+    if (end - p < 2) error("decodeTans: data is truncated");
+    int tableLog = *p++;
+    int lastSymbol = *p++;
+    if (tableLog < TANS_MIN_TABLE_LOG || tableLog > TANS_MAX_TABLE_LOG) error("decodeTans: data is corrupt");
+    int tableSize = 1 << tableLog;
+    int normalized[256] = {0};
+    int total = 0;
+    for (int ch = 0; ch <= lastSymbol; ch++) {
+        if (p >= end) error("decodeTans: data is truncated");
+        int count = *p++;
+        if (count >= 0x80) {
+            if (p >= end) error("decodeTans: data is truncated");
+            count = (count & 0x7f) | (*p++ << 7);
+        }
+        normalized[ch] = count;
+        total += count;
+    }
+    if (total != tableSize) error("decodeTans: data is corrupt");
+    if (end - p < 2 * NUM_STATES + 1) error("decodeTans: data is truncated");
+    int states[NUM_STATES];
+    for (int s = 0; s < NUM_STATES; s++) {
+        states[s] = readUint16(p);
+        p += 2;
+        if (states[s] >= tableSize) error("decodeTans: data is corrupt");
+    }
+    if (end[-1] == 0) error("decodeTans: data is corrupt");
+
+    unsigned char* spread = new unsigned char[tableSize];
+    TansDecodeEntry* table = new TansDecodeEntry[tableSize];
+    spreadSymbols(normalized, tableLog, spread);
+    int next[256];
+    memcpy(next, normalized, sizeof(next));
+    for (int slot = 0; slot < tableSize; slot++) {
+        int ch = spread[slot];
+        int n = next[ch]++;
+        int numBits = tableLog - highestBit(n);
+        table[slot].symbol = (unsigned char) ch;
+        table[slot].numBits = (unsigned char) numBits;
+        table[slot].nextBase = (uint16_t) ((n << numBits) - tableSize);
+    }
+    delete[] spread;
+
+    unsigned char padded[16] = {0};
+    const unsigned char* limit = p;
+    if (end - p < 8) { //copy a short stream behind zeros so the reader can always load 8 bytes
+        memcpy(padded + 16 - (end - p), p, end - p);
+        limit = padded + 8;
+        p = padded + 16 - (end - p);
+        end = padded + 16;
+    }
+    BackwardBitReader reader(limit, p, end);
+    int a = states[0];
+    int b = states[1];
+    int c = states[2];
+    int d = states[3];
+    size_t i = 0;
+    while (i + 4 <= length && reader.reload()) {
+        TansDecodeEntry ea = table[a];
+        TansDecodeEntry eb = table[b];
+        TansDecodeEntry ec = table[c];
+        TansDecodeEntry ed = table[d];
+        output[i] = ea.symbol;
+        output[i + 1] = eb.symbol;
+        output[i + 2] = ec.symbol;
+        output[i + 3] = ed.symbol;
+        a = ea.nextBase + reader.read(ea.numBits);
+        b = eb.nextBase + reader.read(eb.numBits);
+        c = ec.nextBase + reader.read(ec.numBits);
+        d = ed.nextBase + reader.read(ed.numBits);
+        i += 4;
+    }
+    int tail[NUM_STATES] = {a, b, c, d};
+    bool bad = false;
+    for (; i < length; i++) {
+        reader.reload();
+        int& state = tail[i % NUM_STATES];
+        TansDecodeEntry e = table[state];
+        output[i] = e.symbol;
+        state = e.nextBase + reader.readChecked(e.numBits, bad);
+    }
+    delete[] table;
+    //the encoder started every state at slot 0 and every bit must have been used
+    for (int s = 0; s < NUM_STATES; s++) {
+        bad |= tail[s] != 0;
+    }
+    if (bad || reader.bitsLeft() != 0) error("decodeTans: data is corrupt");
+}
@@ -0,0 +1,43 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the tans.h file which declares a table-based asymmetric numeral system (tANS, the coder
+ * in FSE/zstd) for bytes. Like Huffman coding it is driven by a histogram and decodes with one table
+ * lookup per character, but it spends fractional bits: a character with probability p costs close
+ * to -log2(p) bits instead of a whole number of bits, which matters most for very skewed data where
+ * Huffman can't go below one bit per character.
+ *
+ * Encoded layout: table log byte, (last coded character) byte, each character's normalized count
+ * as one byte (under 128) or two, the four final coder states (uint16 each, little-endian), then
+ * the bit stream. The encoder runs backwards over the data, so the decoder reads the bit stream
+ * backwards from its last byte, whose highest set bit marks where the bits end.
+ */
+
+#ifndef _tans_h
+#define _tans_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+const int TANS_MIN_TABLE_LOG = 5;
+const int TANS_MAX_TABLE_LOG = 12;       // 4K-entry decode table, 16 KB, stays in L1 cache
+const int TANS_DEFAULT_TABLE_LOG = 11;
+
+/*
+ * Scales a histogram (counts of each byte, total characters) to counts that add up to exactly
+ * 2^tableLog, keeping every character that occurs at a count of at least 1.
+ */
+void normalizeCounts(const uint64_t counts[256], size_t total, int tableLog, int normalized[256]);
+
+/*
+ * Appends the tANS encoding of length bytes (more than 0) to output, using their histogram counts.
+ */
+void encodeTans(const unsigned char* data, size_t length, const uint64_t counts[256], string& output);
+
+/*
+ * Decodes length bytes from what encodeTans wrote. Throws an error if the data is damaged.
+ */
+void decodeTans(const unsigned char* encoded, size_t encodedLength, unsigned char* output, size_t length);
+
+#endif
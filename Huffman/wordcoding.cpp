@@ -0,0 +1,650 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * Description: This file implements the word-level coder declared in wordcoding.h. The encoder
+ * makes two passes over each chunk: the first cuts it into tokens and counts them in a hash table
+ * keyed by the tokens' bytes, the second codes every token once the vocabulary and its code are
+ * known. The decoder's table entries hold each token's length and its place in one array of all
+ * the vocabulary's bytes, so emitting a token is one lookup and a fixed-size copy: 16 bytes (32
+ * for long tokens) no matter how long it really is, with the bytes copied past its end simply
+ * overwritten by the next token.
+ */
+
+#include "wordcoding.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "BitIO.h"
+#include "HuffmanPool.h"
+#include "blockcodec.h"
+#include "bytes.h"
+#include "checksum.h"
+#include "error.h"
+#include "huffmancode.h"
+
+static const char WORD_MAGIC[] = "HWRD";
+static const int WORD_VERSION = 1;
+static const int WORD_HEADER_BYTES = 5;
+static const int CHUNK_HEADER_BYTES = 12;
+static const int COPY_BYTES = 16;                   //bytes copied per memcpy when decoding
+static const int SLACK_BYTES = 2 * COPY_BYTES;      //room for copying a whole token's worth past the end
+static const int INITIAL_SLOTS = 1 << 16;
+static const int WORD_STREAMS = 4;                  //interleaved streams per chunk
+static const int STREAM_TABLE_BYTES = 8 * (WORD_STREAMS - 1);
+
+/*
+ * Returns true for the bytes that make up words: letters, digits, and every byte of a UTF-8
+ * multibyte character, so words in any language are kept whole.
+ */
+static bool isWordByte(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch >= 0x80;
+}
+
+/*
+ * Returns the length of the token starting at p: the run of bytes of the same kind as the first,
+ * at most WORD_MAX_TOKEN_BYTES long.
+ */
+static int tokenLength(const unsigned char* p, const unsigned char* end) {
+    bool word = isWordByte(*p);
+    int length = 1;
+    while (length < WORD_MAX_TOKEN_BYTES && p + length < end && isWordByte(p[length]) == word) {
+        length++;
+    }
+    return length;
+}
+
+/*
+ * One distinct token of a chunk.
+ */
+struct TokenEntry {
+    uint32_t offset;   // where it first occurs in the chunk
+    uint32_t length;
+    uint32_t count;    // number of times it occurs
+    int symbol;        // its symbol while coding, -1 if it is spelled out byte by byte
+};
+
+/*
+ * Counts the distinct tokens of a chunk in an open-addressing hash table. The table holds
+ * entry numbers plus one (0 for an empty slot), and an entry's bytes are found in the chunk
+ * itself, so no token is ever copied.
+ */
+class TokenCounter {
+public:
+    TokenCounter() {
+        myNumSlots = INITIAL_SLOTS;
+        mySlots = new uint32_t[myNumSlots];
+        myCapacity = INITIAL_SLOTS / 2;
+        myEntries = new TokenEntry[myCapacity];
+        clear(NULL);
+    }
+
+    ~TokenCounter() {
+        delete[] mySlots;
+        delete[] myEntries;
+    }
+
+    /*
+     * Empties the table for the tokens of a new chunk.
+     */
+    void clear(const unsigned char* data) {
+        myData = data;
+        mySize = 0;
+        memset(mySlots, 0, myNumSlots * sizeof(uint32_t));
+    }
+
+    /*
+     * Counts one more occurrence of the token at offset and returns its entry number.
+     */
+    uint32_t add(uint32_t offset, int length) {
+        const unsigned char* token = myData + offset;
+        uint32_t mask = myNumSlots - 1;
+        for (uint32_t slot = hash(token, length) & mask; ; slot = (slot + 1) & mask) {
+            uint32_t index = mySlots[slot];
+            if (index == 0) {
+                if (mySize == myCapacity) grow();
+                if (2 * (mySize + 1) > myNumSlots) { //keep the table at most half full
+                    rehash();
+                    return add(offset, length);
+                }
+                TokenEntry& entry = myEntries[mySize];
+                entry.offset = offset;
+                entry.length = length;
+                entry.count = 1;
+                entry.symbol = -1;
+                mySlots[slot] = ++mySize;
+                return mySize - 1;
+            }
+            TokenEntry& entry = myEntries[index - 1];
+            if (entry.length == (uint32_t) length && memcmp(myData + entry.offset, token, length) == 0) {
+                entry.count++;
+                return index - 1;
+            }
+        }
+    }
+
+    uint32_t size() const {
+        return mySize;
+    }
+
+    TokenEntry& entry(uint32_t index) {
+        return myEntries[index];
+    }
+
+private:
+    TokenCounter(const TokenCounter& other);            // not copyable (owns its arrays)
+    TokenCounter& operator =(const TokenCounter& other);
+
+    static uint32_t hash(const unsigned char* token, int length) {
+        uint32_t h = 2166136261u; //FNV-1a
+        for (int i = 0; i < length; i++) {
+            h = (h ^ token[i]) * 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    void grow() {
+        TokenEntry* entries = new TokenEntry[2 * myCapacity];
+        memcpy(entries, myEntries, mySize * sizeof(TokenEntry));
+        delete[] myEntries;
+        myEntries = entries;
+        myCapacity *= 2;
+    }
+
+    void rehash() {
+        delete[] mySlots;
+        myNumSlots *= 2;
+        mySlots = new uint32_t[myNumSlots];
+        memset(mySlots, 0, myNumSlots * sizeof(uint32_t));
+        uint32_t mask = myNumSlots - 1;
+        for (uint32_t i = 0; i < mySize; i++) {
+            uint32_t slot = hash(myData + myEntries[i].offset, myEntries[i].length) & mask;
+            while (mySlots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            mySlots[slot] = i + 1;
+        }
+    }
+
+    const unsigned char* myData; //the chunk being counted
+    uint32_t* mySlots;
+    uint32_t myNumSlots; //always a power of two
+    TokenEntry* myEntries;
+    uint32_t mySize; //number of entries in use
+    uint32_t myCapacity; //actual size of myEntries
+};
+
+/*
+ * The bytes of a symbol while a chunk is being coded: a pointer into the chunk, or into BYTES
+ * for the single-byte symbols.
+ */
+struct SymbolBytes {
+    const unsigned char* bytes;
+    int length;
+};
+
+static const struct ByteValues {
+    unsigned char value[256];
+    ByteValues() {
+        for (int ch = 0; ch < 256; ch++) {
+            value[ch] = (unsigned char) ch;
+        }
+    }
+} BYTES;
+
+/*
+ * Appends the vocabulary: the number of codes of each length, then the symbols' front-coded
+ * bytes in canonical order.
+ * @order: the symbols in canonical order
+ */
+static void writeVocabulary(const SymbolBytes symbols[], const int order[], const int lengths[], int numCoded,
+                            string& output) {
+    int lengthCounts[WORD_MAX_CODE_LENGTH + 1] = {0};
+    for (int i = 0; i < numCoded; i++) {
+        lengthCounts[lengths[order[i]]]++;
+    }
+    for (int len = 1; len <= WORD_MAX_CODE_LENGTH; len++) {
+        appendVarint(output, lengthCounts[len]);
+    }
+    const SymbolBytes* previous = NULL;
+    for (int i = 0; i < numCoded; i++) {
+        const SymbolBytes& symbol = symbols[order[i]];
+        int shared = 0;
+        if (previous != NULL) {
+            int most = min(previous->length, symbol.length);
+            while (shared < most && previous->bytes[shared] == symbol.bytes[shared]) {
+                shared++;
+            }
+        }
+        output += (char) shared;
+        output += (char) (symbol.length - shared);
+        output.append((const char*) symbol.bytes + shared, symbol.length - shared);
+        previous = &symbol;
+    }
+}
+
+/*
+ * Codes one chunk and appends its header and payload to output.
+ * Big-Oh: O(N + V log V) for N bytes of input and V distinct tokens
+ */
+static void writeChunk(const unsigned char* data, size_t length, TokenCounter& counter, uint32_t* tokens,
+                       string& output) {
+    //pass 1: cut the chunk into tokens and count them, noting the token nearest each quarter
+    counter.clear(data);
+    size_t numTokens = 0;
+    size_t streamTokens[WORD_STREAMS + 1];   //first token of each stream
+    size_t streamBytes[WORD_STREAMS + 1];    //first byte of each stream
+    int nextStream = 0;
+    for (size_t pos = 0; pos < length; ) {
+        while (nextStream < WORD_STREAMS && pos >= nextStream * length / WORD_STREAMS) {
+            streamTokens[nextStream] = numTokens;
+            streamBytes[nextStream++] = pos;
+        }
+        int tokenBytes = tokenLength(data + pos, data + length);
+        tokens[numTokens++] = counter.add((uint32_t) pos, tokenBytes);
+        pos += tokenBytes;
+    }
+    for (; nextStream <= WORD_STREAMS; nextStream++) {
+        streamTokens[nextStream] = numTokens;
+        streamBytes[nextStream] = length;
+    }
+
+    //the vocabulary: single bytes are symbols 0-255, then the most frequent repeated tokens
+    unique_ptr<int[]> candidates(new int[counter.size()]);
+    int numCandidates = 0;
+    for (uint32_t i = 0; i < counter.size(); i++) {
+        TokenEntry& entry = counter.entry(i);
+        if (entry.length == 1) {
+            entry.symbol = data[entry.offset];
+        } else if (entry.count >= (uint32_t) WORD_MIN_COUNT) {
+            candidates[numCandidates++] = i;
+        }
+    }
+    int maxWords = WORD_MAX_SYMBOLS - 256;
+    if (numCandidates > maxWords) {
+        nth_element(candidates.get(), candidates.get() + maxWords, candidates.get() + numCandidates, [&](int a, int b) {
+            uint32_t countA = counter.entry(a).count;
+            uint32_t countB = counter.entry(b).count;
+            return countA != countB ? countA > countB : a < b;
+        });
+        numCandidates = maxWords;
+    }
+    int numSymbols = 256 + numCandidates;
+    unique_ptr<SymbolBytes[]> symbols(new SymbolBytes[numSymbols]);
+    for (int ch = 0; ch < 256; ch++) {
+        symbols[ch].bytes = BYTES.value + ch;
+        symbols[ch].length = 1;
+    }
+    for (int i = 0; i < numCandidates; i++) {
+        TokenEntry& entry = counter.entry(candidates[i]);
+        entry.symbol = 256 + i;
+        symbols[256 + i].bytes = data + entry.offset;
+        symbols[256 + i].length = entry.length;
+    }
+
+    unique_ptr<uint64_t[]> counts(new uint64_t[numSymbols]());
+    for (size_t t = 0; t < numTokens; t++) {
+        const TokenEntry& entry = counter.entry(tokens[t]);
+        if (entry.symbol >= 0) {
+            counts[entry.symbol]++;
+        } else {
+            for (uint32_t i = 0; i < entry.length; i++) {
+                counts[data[entry.offset + i]]++;
+            }
+        }
+    }
+
+    //code lengths, then the canonical order: by code length, then by the symbols' bytes
+    unique_ptr<int[]> lengths(new int[numSymbols]);
+    HuffmanPool pool;
+    pool.build(counts.get(), numSymbols);
+    pool.codeLengths(lengths.get(), numSymbols, WORD_MAX_CODE_LENGTH);
+    unique_ptr<int[]> order(new int[numSymbols]);
+    int numCoded = 0;
+    for (int s = 0; s < numSymbols; s++) {
+        if (lengths[s] > 0) order[numCoded++] = s;
+    }
+    sort(order.get(), order.get() + numCoded, [&](int a, int b) {
+        if (lengths[a] != lengths[b]) return lengths[a] < lengths[b];
+        int compared = memcmp(symbols[a].bytes, symbols[b].bytes, min(symbols[a].length, symbols[b].length));
+        return compared != 0 ? compared < 0 : symbols[a].length < symbols[b].length;
+    });
+    unique_ptr<int[]> canonicalLengths(new int[numCoded]);
+    for (int i = 0; i < numCoded; i++) {
+        canonicalLengths[i] = lengths[order[i]];
+    }
+    HuffmanCode code;
+    code.build(canonicalLengths.get(), numCoded);
+    unique_ptr<uint32_t[]> bits(new uint32_t[numSymbols]);
+    for (int i = 0; i < numCoded; i++) {
+        bits[order[i]] = code.bits(i);
+    }
+
+    string vocabulary;
+    writeVocabulary(symbols.get(), order.get(), lengths.get(), numCoded, vocabulary);
+    BlockOptions options;
+    options.checksummed = false; //the whole payload is checksummed
+    string payload;
+    encodeBlock((const unsigned char*) vocabulary.data(), vocabulary.size(), options, payload);
+
+    //pass 2: the codes, as four streams, then the jump table and the streams
+    string streams[WORD_STREAMS];
+    for (int s = 0; s < WORD_STREAMS; s++) {
+        BitWriter writer(streams[s]);
+        for (size_t t = streamTokens[s]; t < streamTokens[s + 1]; t++) {
+            const TokenEntry& entry = counter.entry(tokens[t]);
+            if (entry.symbol >= 0) {
+                writer.writeBits(bits[entry.symbol], lengths[entry.symbol]);
+            } else {
+                for (uint32_t i = 0; i < entry.length; i++) {
+                    int ch = data[entry.offset + i];
+                    writer.writeBits(bits[ch], lengths[ch]);
+                }
+            }
+        }
+        writer.flush();
+    }
+    for (int s = 0; s < WORD_STREAMS - 1; s++) {
+        appendUint32(payload, (uint32_t) (streamBytes[s + 1] - streamBytes[s]));
+        appendUint32(payload, (uint32_t) streams[s].size());
+    }
+    for (int s = 0; s < WORD_STREAMS; s++) {
+        payload += streams[s];
+    }
+
+    appendUint32(output, (uint32_t) length);
+    appendUint32(output, (uint32_t) payload.size());
+    appendUint32(output, crc32c((const unsigned char*) payload.data(), payload.size()));
+    output += payload;
+}
+
+void compressWords(istream& input, obitstream& output) {
+    output.write(WORD_MAGIC, 4);
+    output.put((char) WORD_VERSION);
+
+    unique_ptr<unsigned char[]> chunk(new unsigned char[WORD_CHUNK_BYTES]);
+    unique_ptr<uint32_t[]> tokens(new uint32_t[WORD_CHUNK_BYTES]);
+    TokenCounter counter;
+    string encoded;
+    while (true) {
+        input.read((char*) chunk.get(), WORD_CHUNK_BYTES);
+        size_t length = (size_t) input.gcount();
+        if (length == 0) break;
+        encoded.clear();
+        writeChunk(chunk.get(), length, counter, tokens.get(), encoded);
+        output.write(encoded.data(), encoded.size());
+        if (length < (size_t) WORD_CHUNK_BYTES) break;
+    }
+    encoded.clear();
+    appendUint32(encoded, 0);
+    appendUint32(encoded, 0);
+    appendUint32(encoded, 0);
+    output.write(encoded.data(), encoded.size());
+}
+
+/*
+ * A decode table entry packs everything needed to emit a token: its code length (0 for bit
+ * patterns that aren't a code), its number of bytes, and where they are in the token array.
+ */
+static const int ENTRY_CODE_BITS = 5;
+static const int ENTRY_LENGTH_BITS = 6;
+static const int ENTRY_OFFSET_SHIFT = ENTRY_CODE_BITS + ENTRY_LENGTH_BITS;
+
+static inline int entryCodeLength(uint32_t entry) {
+    return (int) (entry & ((1 << ENTRY_CODE_BITS) - 1));
+}
+
+static inline uint32_t entryTokenLength(uint32_t entry) {
+    return (entry >> ENTRY_CODE_BITS) & ((1 << ENTRY_LENGTH_BITS) - 1);
+}
+
+static inline uint32_t entryOffset(uint32_t entry) {
+    return entry >> ENTRY_OFFSET_SHIFT;
+}
+
+/*
+ * A chunk's vocabulary, ready to decode with. The arrays are allocated once at their largest
+ * size and reused for every chunk.
+ */
+struct Vocabulary {
+    uint32_t* table;           // 2^tableBits entries, indexed by the upcoming bits
+    uint32_t mask;             // 2^tableBits - 1
+    int tableBits;
+    int* lengths;              // code length of each symbol
+    unsigned char* bytes;      // every token's bytes, followed by SLACK_BYTES of padding
+
+    Vocabulary() {
+        table = new uint32_t[1 << WORD_MAX_CODE_LENGTH];
+        mask = 0;
+        tableBits = 0;
+        lengths = new int[WORD_MAX_SYMBOLS];
+        bytes = new unsigned char[WORD_MAX_SYMBOLS * WORD_MAX_TOKEN_BYTES + SLACK_BYTES];
+    }
+
+    ~Vocabulary() {
+        delete[] table;
+        delete[] lengths;
+        delete[] bytes;
+    }
+
+private:
+    Vocabulary(const Vocabulary& other);            // not copyable (owns its arrays)
+    Vocabulary& operator =(const Vocabulary& other);
+};
+
+/*
+ * Reads a vocabulary written by writeVocabulary and builds its decode table, the same way
+ * HuffmanDecodeTable::build does but with packed token entries.
+ * Returns false if it is damaged.
+ */
+static bool readVocabulary(const unsigned char* p, const unsigned char* end, Vocabulary& vocabulary) {
+    int* lengths = vocabulary.lengths;
+    int numSymbols = 0;
+    uint64_t kraft = 0;
+    for (int len = 1; len <= WORD_MAX_CODE_LENGTH; len++) {
+        uint64_t count;
+        if (!readVarint(p, end, count) || count > (uint64_t) (WORD_MAX_SYMBOLS - numSymbols)) return false;
+        for (uint64_t i = 0; i < count; i++) {
+            lengths[numSymbols++] = len;
+        }
+        kraft += count << (WORD_MAX_CODE_LENGTH - len);
+    }
+    if (numSymbols == 0 || kraft > (uint64_t) 1 << WORD_MAX_CODE_LENGTH) return false;
+
+    HuffmanCode code;
+    code.build(lengths, numSymbols);
+    int tableBits = code.maxLength();
+    uint32_t size = (uint32_t) 1 << tableBits;
+    memset(vocabulary.table, 0, size * sizeof(uint32_t));
+    vocabulary.tableBits = tableBits;
+    vocabulary.mask = size - 1;
+    unsigned char* bytes = vocabulary.bytes;
+    uint32_t used = 0;
+    uint32_t previousOffset = 0;
+    int previousLength = 0;
+    for (int s = 0; s < numSymbols; s++) {
+        if (end - p < 2) return false;
+        int shared = p[0];
+        int rest = p[1];
+        p += 2;
+        if (shared > previousLength || shared + rest < 1 || shared + rest > WORD_MAX_TOKEN_BYTES || end - p < rest) {
+            return false;
+        }
+        memcpy(bytes + used, bytes + previousOffset, shared);
+        memcpy(bytes + used + shared, p, rest);
+        p += rest;
+        uint32_t entry = used << ENTRY_OFFSET_SHIFT | (uint32_t) (shared + rest) << ENTRY_CODE_BITS | lengths[s];
+        for (uint32_t index = code.bits(s); index < size; index += (uint32_t) 1 << lengths[s]) {
+            vocabulary.table[index] = entry;
+        }
+        previousOffset = used;
+        previousLength = shared + rest;
+        used += previousLength;
+    }
+    memset(bytes + used, 0, SLACK_BYTES);
+    return p == end;
+}
+
+/*
+ * Decodes the next token of reader into out, copying COPY_BYTES at a time, and returns its
+ * number of bytes; bad is set if the bits aren't a code.
+ */
+static inline uint32_t decodeToken(BitReader& reader, const Vocabulary& vocabulary, unsigned char* out,
+                                   uint32_t& bad) {
+    uint32_t entry = vocabulary.table[reader.window() & vocabulary.mask];
+    int codeLength = entryCodeLength(entry);
+    bad |= (codeLength == 0);
+    reader.consume(codeLength);
+    const unsigned char* source = vocabulary.bytes + entryOffset(entry);
+    uint32_t length = entryTokenLength(entry);
+    memcpy(out, source, COPY_BYTES);
+    if (length > (uint32_t) COPY_BYTES) memcpy(out + COPY_BYTES, source + COPY_BYTES, COPY_BYTES);
+    return length;
+}
+
+/*
+ * Decodes a chunk's four streams into their parts of output. The main loop refills all four
+ * readers and then decodes a run of tokens from each in turn, so the four lookups overlap, as in
+ * the block format's four-stream blocks. It stops while every stream is still far enough from
+ * the end of its part that the copies can't spill into the next part, which may already have
+ * been written; each stream's last few tokens are then copied exactly.
+ * Returns false if the codes are damaged or a stream doesn't decode to exactly its part.
+ */
+static bool decodeStreams(const Vocabulary& vocabulary, const unsigned char* streams[WORD_STREAMS],
+                          const size_t sizes[WORD_STREAMS], unsigned char* output, const size_t parts[WORD_STREAMS]) {
+    BitReader r0(streams[0], sizes[0]);
+    BitReader r1(streams[1], sizes[1]);
+    BitReader r2(streams[2], sizes[2]);
+    BitReader r3(streams[3], sizes[3]);
+    unsigned char* ends[WORD_STREAMS];
+    unsigned char* outs[WORD_STREAMS];
+    size_t done = 0;
+    for (int s = 0; s < WORD_STREAMS; s++) {
+        outs[s] = output + done;
+        done += parts[s];
+        ends[s] = output + done;
+    }
+    int perRefill = 56 / vocabulary.tableBits;
+    size_t margin = (size_t) (perRefill + 1) * WORD_MAX_TOKEN_BYTES; //most a run of tokens (and its copies) can write
+    uint32_t bad = 0;
+    unsigned char* o0 = outs[0];
+    unsigned char* o1 = outs[1];
+    unsigned char* o2 = outs[2];
+    unsigned char* o3 = outs[3];
+    while ((size_t) (ends[0] - o0) > margin && (size_t) (ends[1] - o1) > margin && (size_t) (ends[2] - o2) > margin
+           && (size_t) (ends[3] - o3) > margin) {
+        r0.refill();
+        r1.refill();
+        r2.refill();
+        r3.refill();
+        for (int k = 0; k < perRefill; k++) {
+            o0 += decodeToken(r0, vocabulary, o0, bad);
+            o1 += decodeToken(r1, vocabulary, o1, bad);
+            o2 += decodeToken(r2, vocabulary, o2, bad);
+            o3 += decodeToken(r3, vocabulary, o3, bad);
+        }
+        if (bad) return false;
+    }
+    outs[0] = o0;
+    outs[1] = o1;
+    outs[2] = o2;
+    outs[3] = o3;
+
+    BitReader* readers[WORD_STREAMS] = {&r0, &r1, &r2, &r3};
+    unsigned char token[SLACK_BYTES];
+    for (int s = 0; s < WORD_STREAMS; s++) {
+        while (outs[s] < ends[s]) {
+            readers[s]->refill();
+            uint32_t length = decodeToken(*readers[s], vocabulary, token, bad);
+            if (bad || length > (size_t) (ends[s] - outs[s])) return false;
+            memcpy(outs[s], token, length);
+            outs[s] += length;
+        }
+        if (readers[s]->bitsAvailable() < 0) return false;
+    }
+    return true;
+}
+
+/*
+ * Checks and decodes one chunk's payload into length bytes of output.
+ * Returns false if it is damaged.
+ */
+static bool readChunk(const unsigned char* payload, size_t payloadLength, uint32_t checksum,
+                      Vocabulary& vocabulary, string& vocabularyBytes, unsigned char* output, size_t length) {
+    if (crc32c(payload, payloadLength) != checksum || payloadLength < (size_t) BLOCK_HEADER_BYTES) return false;
+    BlockHeader header;
+    parseBlockHeader(payload, header);
+    size_t remaining = payloadLength - BLOCK_HEADER_BYTES;
+    if (header.type == BLOCK_END || header.rawLength > (uint32_t) MAX_BLOCK_SIZE || header.payloadLength > remaining) {
+        return false;
+    }
+    vocabularyBytes.resize(header.rawLength);
+    decodeBlock(header, payload + BLOCK_HEADER_BYTES, (unsigned char*) &vocabularyBytes[0]);
+    const unsigned char* start = (const unsigned char*) vocabularyBytes.data();
+    if (!readVocabulary(start, start + vocabularyBytes.size(), vocabulary)) return false;
+
+    const unsigned char* p = payload + BLOCK_HEADER_BYTES + header.payloadLength;
+    remaining -= header.payloadLength;
+    if (remaining < (size_t) STREAM_TABLE_BYTES) return false;
+    const unsigned char* streams[WORD_STREAMS];
+    size_t sizes[WORD_STREAMS];
+    size_t parts[WORD_STREAMS];
+    size_t partsLeft = length;
+    size_t bitsLeft = remaining - STREAM_TABLE_BYTES;
+    for (int s = 0; s < WORD_STREAMS - 1; s++) {
+        parts[s] = readUint32(p + 8 * s);
+        sizes[s] = readUint32(p + 8 * s + 4);
+        if (parts[s] > partsLeft || sizes[s] > bitsLeft) return false;
+        partsLeft -= parts[s];
+        bitsLeft -= sizes[s];
+    }
+    parts[WORD_STREAMS - 1] = partsLeft;
+    sizes[WORD_STREAMS - 1] = bitsLeft;
+    p += STREAM_TABLE_BYTES;
+    for (int s = 0; s < WORD_STREAMS; s++) {
+        streams[s] = p;
+        p += sizes[s];
+    }
+    return decodeStreams(vocabulary, streams, sizes, output, parts);
+}
+
+void decompressWords(ibitstream& input, ostream& output) {
+    unsigned char header[WORD_HEADER_BYTES];
+    input.read((char*) header, WORD_HEADER_BYTES);
+    if (input.gcount() != WORD_HEADER_BYTES || memcmp(header, WORD_MAGIC, 4) != 0) {
+        error("decompressWords: not a word-coded stream");
+    }
+    if (header[4] != WORD_VERSION) {
+        error("decompressWords: unsupported word stream version");
+    }
+
+    //held by unique_ptr so that a damaged vocabulary, which makes decodeBlock or HuffmanCode::build
+    //throw, doesn't leak it
+    unique_ptr<unsigned char[]> chunk(new unsigned char[WORD_CHUNK_BYTES]);
+    Vocabulary vocabulary;
+    string payload;
+    string vocabularyBytes;
+    bool ok = true;
+    while (ok) {
+        unsigned char chunkHeader[CHUNK_HEADER_BYTES];
+        input.read((char*) chunkHeader, CHUNK_HEADER_BYTES);
+        uint32_t length = readUint32(chunkHeader);
+        uint32_t payloadLength = readUint32(chunkHeader + 4);
+        //a symbol is at least one byte and its code at most two, so the codes take at most 2
+        //bytes per byte of output; the vocabulary lists fewer than WORD_MAX_SYMBOLS tokens
+        uint64_t maxPayload = 2 * (uint64_t) length + (uint64_t) WORD_MAX_SYMBOLS * (WORD_MAX_TOKEN_BYTES + 2)
+                + (uint64_t) 4 * BLOCK_HEADER_BYTES;
+        if (input.gcount() != CHUNK_HEADER_BYTES || length > (uint32_t) WORD_CHUNK_BYTES
+                || payloadLength > maxPayload || (length == 0) != (payloadLength == 0)) {
+            ok = false;
+            break;
+        }
+        if (length == 0) break;
+        payload.resize(payloadLength);
+        input.read(&payload[0], payloadLength);
+        ok = (uint32_t) input.gcount() == payloadLength
+                && readChunk((const unsigned char*) payload.data(), payloadLength, readUint32(chunkHeader + 8),
+                             vocabulary, vocabularyBytes, chunk.get(), length);
+        if (ok) output.write((const char*) chunk.get(), length);
+    }
+    if (!ok) error("decompressWords: compressed data is corrupt or truncated");
+}
@@ -0,0 +1,58 @@
+/*
+ * Authors: Philip Clark and Susannah Meyer
+ * This is the wordcoding.h file which declares word-level Huffman coding for text. The other
+ * coders give every byte its own code, so English text costs one table lookup per character and
+ * can never beat about 4.5 bits per character. Here the input is cut into tokens (runs of letters
+ * and digits, and runs of everything else, such as the spaces and punctuation between words) and
+ * each common token gets a code of its own. A symbol then stands for a whole word or separator,
+ * which is both smaller (a frequent word costs a few bits in all) and faster to decode, because
+ * each lookup writes several bytes.
+ *
+ * The alphabet is different for every chunk of input: the tokens that occur at least
+ * WORD_MIN_COUNT times, up to WORD_MAX_SYMBOLS of them, plus every single byte that occurs.
+ * A token that didn't make it into the vocabulary is spelled out with the byte symbols, so any
+ * input can be coded. The decoder doesn't need to know where one token ends and the next starts;
+ * it just copies each symbol's bytes.
+ *
+ * Stream layout: "HWRD", version byte, then chunks, each with a header (decoded length uint32,
+ * payload length uint32, CRC-32C of the payload uint32, all little-endian) and a payload, ending
+ * with a header whose lengths are both 0. A payload is the chunk's vocabulary, coded as one block
+ * of the block format (see blockcodec.h), then the codes. The chunk's tokens are split into four
+ * runs of about a quarter of its bytes each, coded as four byte-aligned bit streams (first bit
+ * lowest) so a decoder can advance four cursors at once: a jump table of the first three runs'
+ * decoded lengths and stream sizes (uint32 pairs), then the four streams.
+ * The vocabulary lists the number of symbols with each code length from 1 to WORD_MAX_CODE_LENGTH
+ * (variable-length integers, see bytes.h), then every symbol's bytes in canonical order: shorter
+ * codes first, and tokens in byte order within a length. Each token is front coded, as the number
+ * of leading bytes it shares with the token before it (byte), the number of bytes that follow
+ * (byte), and those bytes. The code lengths are implied by the counts, so the vocabulary costs
+ * little more than the tokens' own text.
+ */
+
+#ifndef _wordcoding_h
+#define _wordcoding_h
+
+#include <iostream>
+#include "bitstream.h"
+using namespace std;
+
+const int WORD_CHUNK_BYTES = 1 << 22;      // input coded with one vocabulary (4 MB)
+const int WORD_MAX_TOKEN_BYTES = 32;       // longer runs are cut into several tokens
+const int WORD_MAX_SYMBOLS = 1 << 15;      // vocabulary size, single bytes included
+const int WORD_MAX_CODE_LENGTH = 16;       // 64K-entry decode tables
+const int WORD_MIN_COUNT = 2;              // a token seen once is cheaper to spell out
+
+/*
+ * Compresses the input with word-level codes, a chunk of up to WORD_CHUNK_BYTES at a time.
+ * Meant for text; other data still round-trips, but usually comes out larger than with the
+ * byte-level block format.
+ */
+void compressWords(istream& input, obitstream& output);
+
+/*
+ * Decompresses a stream written by compressWords. Throws an error if the data is not in the
+ * word format or is damaged.
+ */
+void decompressWords(ibitstream& input, ostream& output);
+
+#endif